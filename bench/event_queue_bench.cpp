@@ -0,0 +1,71 @@
+/**
+ * @file event_queue_bench.cpp
+ * @brief Hold-model benchmark for the event-queue backends.
+ * Each pending event stands for one Poisson source: a hold pops the earliest
+ * event and reschedules it after an exponential gap at that source's rate,
+ * which is exactly the access pattern of the simulator's arrival chain.
+ * Every pop is checked for time order, so the run doubles as a sanity check.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <stdexcept>
+
+#include "../sim/event_queue.h"
+
+template <class EventQueue>
+static double benchmarkHold(size_t numSources, size_t holds) {
+    std::mt19937_64 rng(12345);
+    std::uniform_real_distribution<double> rateDist(10.0, 100.0);
+    std::vector<std::exponential_distribution<double>> gaps;
+    for (size_t i = 0; i < numSources; ++i) gaps.emplace_back(rateDist(rng));
+
+    EventQueue queue;
+    for (size_t i = 0; i < numSources; ++i) {
+        queue.push(Event(Event::PACKET_ARRIVAL, gaps[i](rng), static_cast<uint32_t>(i)));
+    }
+
+    double lastTime = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t h = 0; h < holds; ++h) {
+        Event e = queue.pop();
+        if (e.time < lastTime) throw std::logic_error(std::string(EventQueue::name()) + " popped out of order");
+        lastTime = e.time;
+        queue.push(Event(Event::PACKET_ARRIVAL, e.time + gaps[e.index](rng), e.index));
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    if (queue.size() != numSources) throw std::logic_error(std::string(EventQueue::name()) + " lost events");
+    return std::chrono::duration<double, std::nano>(end - start).count() / holds;
+}
+
+template <class EventQueue>
+static void report(size_t numSources, size_t holds) {
+    double ns = benchmarkHold<EventQueue>(numSources, holds);
+    std::cout << std::setw(8) << EventQueue::name() << " | "
+              << std::setw(9) << numSources << " | "
+              << std::setw(12) << std::fixed << std::setprecision(1) << ns << "\n";
+}
+
+int main() {
+    const size_t holds = 2000000;
+    const size_t sourceCounts[] = {10, 1000, 100000};
+
+    std::cout << "Backend  |   Sources | ns per hold\n"
+              << "-----------------------------------\n";
+    try {
+        for (size_t n : sourceCounts) {
+            report<BinaryHeapQueue>(n, holds);
+            report<QuaternaryHeapQueue>(n, holds);
+            report<CalendarQueue>(n, holds);
+            report<LadderQueue>(n, holds);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
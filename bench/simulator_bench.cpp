@@ -0,0 +1,191 @@
+/**
+ * @file simulator_bench.cpp
+ * @brief End-to-end throughput benchmark for the FCFS, WFQ, DRR and SFQ engines.
+ * Runs each discipline over a fixed grid of synthetic scenarios (light and
+ * heavy load, 10 to 100k sources, small and large buffers) and prints one
+ * JSON object per scenario with events/sec, ns/event, peak RSS and heap
+ * allocation counts. The counts cover operator new only; the cache-aligned
+ * per-source arrays come from posix_memalign and are not included. Each
+ * scenario runs in a forked child so that its peak RSS is not inflated by
+ * earlier scenarios.
+ */
+
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../sim/fcfs.h"
+#include "../sim/wfq.h"
+#include "../sim/drr.h"
+#include "../sim/sfq.h"
+
+// Counts every operator new allocation made by this process
+static std::atomic<unsigned long long> allocationCount(0);
+
+static void* countedAlloc(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size) { return countedAlloc(size); }
+void* operator new[](size_t size) { return countedAlloc(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+/// @brief One benchmark point.
+struct Scenario {
+    const char* load; // "light" or "heavy"
+    double utilization;
+    int numSources;
+    size_t bufferSize;
+};
+
+/**
+ * @brief Synthetic scenario: a 1 MB/s link, 500-1500 byte packets and equal
+ * Poisson sources whose total offered load is scenario.utilization.
+ */
+static Config makeConfig(const Scenario& scenario, double simulationTime) {
+    Config config;
+    config.numSources = scenario.numSources;
+    config.simulationTime = simulationTime;
+    config.linkCapacity = 1.0e6;
+    config.bufferSize = scenario.bufferSize;
+
+    double packetsPerSecond = scenario.utilization * config.linkCapacity / 1000.0;
+    for (int i = 0; i < scenario.numSources; ++i) {
+        SourceConfig src;
+        src.packetRate = packetsPerSecond / scenario.numSources;
+        src.minSize = 500;
+        src.maxSize = 1500;
+        src.weight = 1.0 + (i % 4);
+        src.startFraction = 0.0;
+        src.endFraction = 1.0;
+        config.sources.push_back(src);
+    }
+    return config;
+}
+
+template <class Discipline>
+static std::string runScenario(const Scenario& scenario, double simulationTime) {
+    Config config = makeConfig(scenario, simulationTime);
+
+    unsigned long long allocStart = allocationCount.load();
+    Simulator<Discipline> sim;
+    sim.configure(config);
+    sim.seed(1);
+    unsigned long long allocBeforeRun = allocationCount.load();
+
+    auto start = std::chrono::steady_clock::now();
+    sim.run();
+    auto end = std::chrono::steady_clock::now();
+    unsigned long long allocEnd = allocationCount.load();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    uint64_t events = sim.eventCount();
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    std::ostringstream json;
+    json << std::fixed << std::setprecision(1)
+         << "{\"discipline\": \"" << Discipline::name() << "\""
+         << ", \"load\": \"" << scenario.load << "\""
+         << ", \"sources\": " << scenario.numSources
+         << ", \"buffer\": " << scenario.bufferSize
+         << ", \"events\": " << events
+         << ", \"seconds\": " << std::setprecision(4) << seconds
+         << ", \"events_per_sec\": " << std::setprecision(0) << (seconds > 0 ? events / seconds : 0.0)
+         << ", \"ns_per_event\": " << std::setprecision(2) << (events > 0 ? seconds * 1e9 / events : 0.0)
+         << ", \"peak_rss_kb\": " << usage.ru_maxrss
+         << ", \"allocations_setup\": " << (allocBeforeRun - allocStart)
+         << ", \"allocations_run\": " << (allocEnd - allocBeforeRun)
+         << "}";
+    return json.str();
+}
+
+/// @brief Runs fn in a forked child and returns the line it writes back.
+template <class Fn>
+static std::string isolated(Fn fn) {
+    int fds[2];
+    if (pipe(fds) != 0) throw std::runtime_error("pipe failed");
+    pid_t pid = fork();
+    if (pid < 0) throw std::runtime_error("fork failed");
+    if (pid == 0) {
+        close(fds[0]);
+        std::string line;
+        try {
+            line = fn();
+        } catch (const std::exception& e) {
+            line = std::string("{\"error\": \"") + e.what() + "\"}";
+        }
+        ssize_t ignored = write(fds[1], line.data(), line.size());
+        (void)ignored;
+        close(fds[1]);
+        _exit(0);
+    }
+
+    close(fds[1]);
+    std::string line;
+    char buf[512];
+    ssize_t n;
+    while ((n = read(fds[0], buf, sizeof(buf))) > 0) line.append(buf, static_cast<size_t>(n));
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return line;
+}
+
+int main(int argc, char* argv[]) {
+    // Simulated seconds per scenario; about 2-5 million events at the default
+    double simulationTime = 2000.0;
+    if (argc == 3 && std::strcmp(argv[1], "--time") == 0) {
+        char* end = nullptr;
+        simulationTime = std::strtod(argv[2], &end);
+        if (end == argv[2] || *end != '\0' || !(simulationTime > 0) || std::isinf(simulationTime)) {
+            std::cerr << "--time must be a positive number of simulated seconds\n";
+            return 1;
+        }
+    } else if (argc != 1) {
+        std::cerr << "Usage: " << argv[0] << " [--time <simulated seconds>]\n";
+        return 1;
+    }
+
+    std::vector<Scenario> scenarios;
+    const char* loads[] = {"light", "heavy"};
+    const double utilizations[] = {0.5, 1.2};
+    const int sourceCounts[] = {10, 1000, 100000};
+    const size_t bufferSizes[] = {100, 10000};
+    for (int l = 0; l < 2; ++l) {
+        for (int n : sourceCounts) {
+            for (size_t b : bufferSizes) scenarios.push_back(Scenario{loads[l], utilizations[l], n, b});
+        }
+    }
+
+    std::cout << "[\n";
+    for (size_t i = 0; i < scenarios.size(); ++i) {
+        const Scenario& s = scenarios[i];
+        std::cout << "  " << isolated([&] { return runScenario<FCFSDiscipline>(s, simulationTime); }) << ",\n";
+        std::cout << "  " << isolated([&] { return runScenario<WFQDiscipline>(s, simulationTime); }) << ",\n";
+        std::cout << "  " << isolated([&] { return runScenario<DRRDiscipline>(s, simulationTime); }) << ",\n";
+        std::cout << "  " << isolated([&] { return runScenario<SFQDiscipline>(s, simulationTime); })
+                  << (i + 1 < scenarios.size() ? "," : "") << "\n";
+        std::cout.flush();
+    }
+    std::cout << "]\n";
+    return 0;
+}
@@ -0,0 +1,381 @@
+/**
+ * @file analytic.h
+ * @brief Closed-form estimates of the single-link system these simulations model.
+ * With Poisson sources and uniform packet sizes, the link is an M/G/1/K
+ * queue. K = BUFFER_SIZE + 1 counts the packet in transmission, and the
+ * service time is size / capacity, drawn from the rate-weighted mixture of
+ * the sources' size ranges. The M/G/1/K solution is exact (Gross & Harris,
+ * sec. 6.1.3): the number left behind at departures is a Markov chain over
+ * 0..K-1 whose transitions are the Poisson arrival counts during one
+ * service. Its stationary law is found with the level-crossing recursion
+ *   pi_{j+1} a_0 = pi_0 abar_j + sum_{i=1..j} pi_i abar_{j-i+1},
+ * where abar_k = P(more than k arrivals). The time-average law follows as
+ * p_j = pi_j / (pi_0 + rho) and p_K = 1 - 1 / (pi_0 + rho). Below saturation
+ * p_K is instead summed from the infinite-buffer chain's tail, so neither
+ * step subtracts and drop probabilities far below 1e-9 keep full relative
+ * precision.
+ *
+ * M/M/1/K (exponential service of the same mean) and the infinite-buffer
+ * M/G/1 Pollaczek-Khinchine formula are reported alongside for reference.
+ * The estimates are exact for FCFS with a packet-count buffer. They do not
+ * carry over to WFQ, DRR or SFQ: those schedulers reorder packets of
+ * different sizes and drop a different packet when the buffer is full, so
+ * their delay and drop figures differ and the sweep prescreen is limited to
+ * FCFS. Byte limits become an equivalent packet count at the mean size.
+ * Sources active only part of the run enter at their time-averaged rate,
+ * and on/off, Pareto and MMPP sources and flow classes as Poisson at their
+ * long-run rate, which understates their queueing. The report flags each
+ * of these approximations. Empirical size tables enter the service law
+ * exactly.
+ */
+
+#ifndef SIM_ANALYTIC_H
+#define SIM_ANALYTIC_H
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <stdexcept>
+
+#include "config.h"
+
+/// @brief System-level figures of one queueing model.
+struct AnalyticEstimate {
+    bool stable = true;    // False for M/G/1 at rho >= 1
+    double utilization = 0.0;
+    double avgDelay = 0.0; // Seconds in the system, transmission included
+    double dropProbability = 0.0;
+};
+
+/// @brief Per-source M/G/1/K figures under FCFS.
+struct AnalyticSource {
+    double weight = 0.0;
+    double dropRate = 0.0;
+    double avgDelay = 0.0;
+    double throughput = 0.0; // Bytes per second
+};
+
+/// @brief Closed-form estimates for one scenario.
+struct AnalyticResult {
+    size_t capacity = 0;        // K, packets in the system
+    double arrivalRate = 0.0;   // Packets per second
+    double offeredLoad = 0.0;   // rho = lambda E[S]
+    double meanService = 0.0;   // Seconds
+    bool windowsAveraged = false;  // Sources with on/off windows entered at their average rate
+    bool bytesApproximated = false; // The byte limit became a packet count
+    bool poissonApproximated = false; // Non-Poisson sources entered as Poisson
+    AnalyticEstimate mg1k;
+    AnalyticEstimate mm1k;
+    AnalyticEstimate mg1;
+    double fairness = 0.0;      // Jain's index of the FCFS throughputs
+    std::vector<AnalyticSource> sources;
+};
+
+/**
+ * @brief Stationary M/G/1/K solution from a_0, the probability of no
+ * arrival during a service, and the tail abar[k] = P(more than k arrivals),
+ * which is zero past its length.
+ */
+inline AnalyticEstimate solveMG1K(double a0, const std::vector<double>& abar, size_t K, double lambda, double rho) {
+    // q_j is the departure-epoch law up to a constant, q_0 = 1. Below K it
+    // coincides with the infinite-buffer chain's, so for rho < 1 that
+    // chain's tail beyond K gives p_K as a sum of positive terms
+    std::vector<double> q(1, 1.0);
+    auto extend = [&]() {
+        size_t j = q.size() - 1;
+        double up = j < abar.size() ? q[0] * abar[j] : 0.0;
+        size_t from = j + 2 > abar.size() ? std::max<size_t>(1, j + 2 - abar.size()) : 1;
+        for (size_t i = from; i <= j; ++i) up += q[i] * abar[j - i + 1];
+        q.push_back(up / a0);
+        if (q.back() > 1e250) {
+            // Heavy overload: rescale so the chain stays finite
+            for (double& x : q) x *= 1e-250;
+        }
+    };
+    while (q.size() < K) extend();
+    double sum = 0.0, weighted = 0.0;
+    for (size_t j = 0; j < K; ++j) {
+        sum += q[j];
+        weighted += j * q[j];
+    }
+    double scale = q[0]; // 1 unless rescaled
+    double total = scale + rho * sum;
+
+    AnalyticEstimate e;
+    // p_K = 1 - 1 / (pi_0 + rho) with pi_0 = q_0 / sum
+    double lossMass = total - sum;
+    if (rho < 1.0 && scale == 1.0) {
+        double beyond = 0.0;
+        const size_t maxSteps = 20000;
+        for (size_t step = 0; step < maxSteps; ++step) {
+            extend();
+            double t = q.back();
+            beyond += t;
+            if (t < 1e-17 * beyond && step > abar.size()) {
+                lossMass = (1.0 - rho) * beyond;
+                break;
+            }
+        }
+    }
+    e.dropProbability = std::max(0.0, lossMass) / total;
+    e.utilization = rho * sum / total;
+    double inSystem = weighted / total + K * e.dropProbability;
+    double admitted = lambda * (1.0 - e.dropProbability);
+    e.avgDelay = admitted > 0.0 ? inSystem / admitted : 0.0;
+    return e;
+}
+
+/// @brief M/M/1/K with service rate mu; weights are normalized from the top state when rho > 1.
+inline AnalyticEstimate solveMM1K(size_t K, double lambda, double mu) {
+    double rho = lambda / mu;
+    std::vector<double> w(K + 1);
+    for (size_t n = 0; n <= K; ++n) {
+        w[n] = rho <= 1.0 ? std::pow(rho, static_cast<double>(n)) : std::pow(1.0 / rho, static_cast<double>(K - n));
+    }
+    double total = 0.0, weighted = 0.0;
+    for (size_t n = 0; n <= K; ++n) {
+        total += w[n];
+        weighted += n * w[n];
+    }
+    AnalyticEstimate e;
+    e.dropProbability = w[K] / total;
+    e.utilization = 1.0 - w[0] / total;
+    double admitted = lambda * (1.0 - e.dropProbability);
+    e.avgDelay = admitted > 0.0 ? (weighted / total) / admitted : 0.0;
+    return e;
+}
+
+/// @brief Pollaczek-Khinchine mean delay of the infinite-buffer M/G/1 queue.
+inline AnalyticEstimate solveMG1(double lambda, double meanService, double secondMoment) {
+    AnalyticEstimate e;
+    double rho = lambda * meanService;
+    if (rho >= 1.0) {
+        e.stable = false;
+        e.utilization = 1.0;
+        return e;
+    }
+    e.utilization = rho;
+    e.avgDelay = lambda * secondMoment / (2.0 * (1.0 - rho)) + meanService;
+    return e;
+}
+
+/**
+ * @brief Solves the scenario. `systemOnly` skips the per-source figures
+ * and the reference models, as the sweep prescreen needs none of them.
+ */
+inline AnalyticResult analyzeScenario(const Config& config, bool systemOnly = false) {
+    AnalyticResult r;
+    const double runLength = 1.0; // Windows are fractions of the run
+    int lo = 0, hi = 0;
+    bool first = true;
+    std::vector<double> rates;
+    r.poissonApproximated = !poissonArrivals(config);
+    for (size_t i = 0; i < config.sources.size(); ++i) {
+        const SourceConfig& sc = config.sources[i];
+        double active = std::max(0.0, std::min(sc.endFraction, runLength) - std::max(sc.startFraction, 0.0));
+        if (active != runLength) r.windowsAveraged = true;
+        rates.push_back(meanPacketRate(config, i) * active);
+        r.arrivalRate += rates.back();
+        if (first || sc.minSize < lo) lo = sc.minSize;
+        if (first || sc.maxSize > hi) hi = sc.maxSize;
+        first = false;
+    }
+
+    AnalyticEstimate none;
+    if (r.arrivalRate <= 0.0 || config.linkCapacity <= 0.0) {
+        r.mg1k = r.mm1k = r.mg1 = none;
+        r.capacity = config.bufferSize + 1;
+        r.sources.assign(config.sources.size(), AnalyticSource());
+        for (size_t i = 0; i < config.sources.size(); ++i) r.sources[i].weight = config.sources[i].weight;
+        return r;
+    }
+
+    // Rate-weighted size law over [lo, hi], built with a difference array
+    std::vector<double> sizeLaw(static_cast<size_t>(hi - lo) + 2, 0.0);
+    double meanSize = 0.0, sizeSquare = 0.0;
+    for (size_t i = 0; i < config.sources.size(); ++i) {
+        const SourceConfig& sc = config.sources[i];
+        double mass = rates[i] / r.arrivalRate;
+        int table = trafficModel(config, i).sizeTable;
+        if (table >= 0) {
+            const SizeTable& t = config.sizeTables[table];
+            double total = 0.0;
+            for (double w : t.weights) total += w;
+            for (size_t k = 0; k < t.sizes.size(); ++k) {
+                double m = mass * t.weights[k] / total;
+                sizeLaw[t.sizes[k] - lo] += m;
+                sizeLaw[t.sizes[k] - lo + 1] -= m;
+                meanSize += m * t.sizes[k];
+                sizeSquare += m * t.sizes[k] * static_cast<double>(t.sizes[k]);
+            }
+            continue;
+        }
+        double span = sc.maxSize - sc.minSize + 1.0;
+        sizeLaw[sc.minSize - lo] += mass / span;
+        sizeLaw[sc.maxSize - lo + 1] -= mass / span;
+        double m1 = 0.5 * (sc.minSize + sc.maxSize);
+        double m2 = (span * span - 1.0) / 12.0 + m1 * m1; // Discrete uniform
+        meanSize += mass * m1;
+        sizeSquare += mass * m2;
+    }
+    for (size_t k = 1; k < sizeLaw.size(); ++k) sizeLaw[k] += sizeLaw[k - 1];
+
+    double lambda = r.arrivalRate;
+    r.meanService = meanSize / config.linkCapacity;
+    double secondMoment = sizeSquare / (config.linkCapacity * config.linkCapacity);
+    r.offeredLoad = lambda * r.meanService;
+
+    size_t buffered = config.bufferSize;
+    if (config.bufferBytes > 0) {
+        size_t equivalent = static_cast<size_t>(config.bufferBytes / meanSize);
+        if (equivalent < buffered) {
+            buffered = equivalent;
+            r.bytesApproximated = true;
+        }
+    }
+    size_t K = buffered + 1;
+    r.capacity = K;
+
+    // Arrivals during one service: a_k, with enough terms that the tail
+    // past them is zero to rounding
+    double xMax = lambda * hi / config.linkCapacity;
+    size_t terms = 64 + static_cast<size_t>(xMax + 12.0 * std::sqrt(xMax));
+    std::vector<double> a(terms, 0.0);
+    for (int s = lo; s <= hi; ++s) {
+        double mass = sizeLaw[s - lo];
+        if (mass <= 0.0) continue;
+        double x = lambda * s / config.linkCapacity;
+        double logX = std::log(x);
+        double p = std::exp(-x);
+        for (size_t k = 0; k < terms; ++k) {
+            if (x > 600.0) p = std::exp(k * logX - x - std::lgamma(k + 1.0)); // exp(-x) underflows
+            else if (k > 0) p *= x / k;
+            if (p < 1e-300 && k > x) break;
+            a[k] += mass * p;
+        }
+    }
+    std::vector<double> abar(terms, 0.0);
+    double tail = 0.0;
+    for (size_t k = terms; k-- > 0;) {
+        abar[k] = tail;
+        tail += a[k];
+    }
+    r.mg1k = solveMG1K(a[0], abar, K, lambda, r.offeredLoad);
+    if (systemOnly) return r;
+
+    r.mm1k = solveMM1K(K, lambda, 1.0 / r.meanService);
+    r.mg1 = solveMG1(lambda, r.meanService, secondMoment);
+
+    // FCFS: every source sees the same queue and loss; only its own
+    // transmission time differs
+    double waiting = r.mg1k.avgDelay - r.meanService;
+    double sum = 0.0, sumSquares = 0.0;
+    for (size_t i = 0; i < config.sources.size(); ++i) {
+        const SourceConfig& sc = config.sources[i];
+        double size = meanPacketSize(config, i);
+        AnalyticSource src;
+        src.weight = sc.weight;
+        src.dropRate = r.mg1k.dropProbability;
+        src.avgDelay = waiting + size / config.linkCapacity;
+        src.throughput = rates[i] * (1.0 - r.mg1k.dropProbability) * size;
+        sum += src.throughput;
+        sumSquares += src.throughput * src.throughput;
+        r.sources.push_back(src);
+    }
+    r.fairness = sumSquares > 0.0 ? sum * sum / (r.sources.size() * sumSquares) : 0.0;
+    return r;
+}
+
+/// @brief Sweep points whose M/G/1/K estimate violates a bound are not simulated.
+struct AnalyticScreen {
+    double maxDrop = HUGE_VAL;
+    double maxDelay = HUGE_VAL;
+    double minUtilization = 0.0;
+
+    bool passes(const AnalyticEstimate& e) const {
+        return e.dropProbability <= maxDrop && e.avgDelay <= maxDelay && e.utilization >= minUtilization;
+    }
+};
+
+/**
+ * @brief Parses "max_drop=<p>,max_delay=<s>,min_utilization=<u>"; any
+ * subset of the bounds may be given.
+ */
+inline AnalyticScreen parseAnalyticScreen(const std::string& spec) {
+    AnalyticScreen screen;
+    std::stringstream list(spec);
+    std::string item;
+    bool any = false;
+    while (std::getline(list, item, ',')) {
+        size_t eq = item.find('=');
+        std::string key = item.substr(0, eq);
+        char* end = nullptr;
+        double v = eq == std::string::npos ? 0.0 : std::strtod(item.c_str() + eq + 1, &end);
+        if (eq == std::string::npos || end == item.c_str() + eq + 1 || *end != '\0' || v < 0.0) {
+            throw std::invalid_argument("Bad prescreen bound: " + item);
+        }
+        if (key == "max_drop") screen.maxDrop = v;
+        else if (key == "max_delay") screen.maxDelay = v;
+        else if (key == "min_utilization") screen.minUtilization = v;
+        else throw std::invalid_argument("Unknown prescreen bound: " + key);
+        any = true;
+    }
+    if (!any) throw std::invalid_argument("Prescreen needs at least one bound");
+    return screen;
+}
+
+/**
+ * @brief Outputs the estimates in the printResults layout.
+ */
+inline void printAnalyticResults(std::ostream& out, const AnalyticResult& r) {
+    out << std::fixed << std::setprecision(6);
+    out << "## Analytic Estimates (M/G/1/K, K = " << r.capacity << " packets in the system)\n"
+        << "1. Server Utilization:   " << r.mg1k.utilization << "\n"
+        << "2. Avg. Packet Delay:    " << r.mg1k.avgDelay << " s\n"
+        << "3. Packet Drop Prob.:    " << std::scientific << r.mg1k.dropProbability << std::fixed << "\n"
+        << "4. Fairness Index:       " << r.fairness << "\n"
+        << "5. Offered Load:         " << r.offeredLoad << "\n";
+    if (r.windowsAveraged) out << "Approximation: sources with on/off windows enter at their time-averaged rate\n";
+    if (r.poissonApproximated) out << "Approximation: non-Poisson sources enter as Poisson at their mean rate\n";
+    if (r.bytesApproximated) out << "Approximation: the byte limit is taken as " << r.capacity - 1 << " packets of mean size\n";
+
+    out << "\n## Model Comparison\n"
+        << "---------------------------------------------------------\n"
+        << "Model   | Utilization | Avg Delay (s) |   Drop Prob.\n"
+        << "---------------------------------------------------------\n";
+    const char* names[] = {"M/G/1/K", "M/M/1/K", "M/G/1  "};
+    const AnalyticEstimate* models[] = {&r.mg1k, &r.mm1k, &r.mg1};
+    for (int m = 0; m < 3; ++m) {
+        out << names[m] << " | " << std::setw(11) << models[m]->utilization << " | ";
+        if (models[m]->stable) {
+            out << std::setw(13) << models[m]->avgDelay << " | "
+                << std::setw(12) << std::scientific << std::setprecision(4) << models[m]->dropProbability
+                << std::fixed << std::setprecision(6) << "\n";
+        } else {
+            out << std::setw(13) << "unstable" << " | " << std::setw(12) << "-" << "\n";
+        }
+    }
+    out << "---------------------------------------------------------\n";
+
+    out << "\n## Per-Source Estimates (FCFS)\n"
+        << "------------------------------------------------------------\n"
+        << "Src | Weight |  Drop Rate  | Avg Delay (s) | Thruput (B/s)\n"
+        << "------------------------------------------------------------\n";
+    for (size_t i = 0; i < r.sources.size(); ++i) {
+        const AnalyticSource& s = r.sources[i];
+        out << std::setw(3) << i << " | "
+            << std::setw(6) << s.weight << " | "
+            << std::setw(11) << std::scientific << std::setprecision(4) << s.dropRate << std::fixed << " | "
+            << std::setw(13) << std::setprecision(6) << s.avgDelay << " | "
+            << std::setw(13) << std::setprecision(2) << s.throughput << "\n";
+    }
+    out << "------------------------------------------------------------\n" << std::setprecision(6);
+}
+
+#endif // SIM_ANALYTIC_H
@@ -0,0 +1,344 @@
+/**
+ * @file aqm.h
+ * @brief Active queue management stages: RED, CoDel and PIE.
+ * An AQM stage sits in front of (enqueue) or behind (dequeue) whichever
+ * discipline the engine runs, and decides per packet whether to drop it
+ * early, before the buffer itself overflows. Each decision is made from a
+ * queueing-delay signal:
+ *   - at dequeue, the sojourn time of the departing packet, measured from
+ *     Packet::arrivalTime;
+ *   - at enqueue, the buffered bytes the arrival finds divided by the link
+ *     capacity. For FCFS this is its wait, less the residual service of
+ *     the packet on the link.
+ * All three controllers do constant work per packet. PIE's periodic
+ * probability update is caught up lazily at the next decision.
+ */
+
+#ifndef SIM_AQM_H
+#define SIM_AQM_H
+
+#include <cmath>
+#include <string>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+
+#include "config.h"
+#include "random.h"
+
+/// @brief Controller run by an AQMStage.
+enum class AQMPolicy { NONE, RED, CODEL, PIE };
+
+/// @brief Where in the packet path the stage makes its decision.
+enum class AQMPoint { ENQUEUE, DEQUEUE };
+
+/// @brief Stage selection and controller parameters; zero picks the default.
+struct AQMConfig {
+    AQMPolicy policy = AQMPolicy::NONE;
+    AQMPoint point = AQMPoint::ENQUEUE;
+    bool pointSet = false; // When false the controller's usual point is used
+
+    // RED (Floyd & Jacobson, 1993); thresholds are in packets
+    double redMinThreshold = 0.0; // Default: a quarter of the buffer
+    double redMaxThreshold = 0.0; // Default: three quarters of the buffer
+    double redMaxProbability = 0.1;
+    double redWeight = 0.002;     // EWMA gain of the average queue length
+
+    // CoDel (RFC 8289) and PIE (RFC 8033); delays in seconds
+    double target = 0.0;          // Default: 5 ms for CoDel, 15 ms for PIE
+    double interval = 0.1;        // CoDel sliding-minimum window
+    double pieUpdate = 0.015;     // PIE probability update period
+    double pieAlpha = 0.125;
+    double pieBeta = 1.25;
+    double pieMaxBurst = 0.15;
+};
+
+inline const char* aqmPolicyName(AQMPolicy policy) {
+    switch (policy) {
+        case AQMPolicy::RED: return "RED";
+        case AQMPolicy::CODEL: return "CoDel";
+        case AQMPolicy::PIE: return "PIE";
+        case AQMPolicy::NONE: break;
+    }
+    return "none";
+}
+
+/**
+ * @brief Parses "<none|red|codel|pie>[:key=value,...]", e.g.
+ * "red:min=5,max=15,p=0.1" or "codel:target=0.002,interval=0.05".
+ */
+inline AQMConfig parseAQMSpec(const std::string& spec) {
+    AQMConfig c;
+    size_t colon = spec.find(':');
+    std::string name = spec.substr(0, colon);
+    if (name == "none") c.policy = AQMPolicy::NONE;
+    else if (name == "red") c.policy = AQMPolicy::RED;
+    else if (name == "codel") c.policy = AQMPolicy::CODEL;
+    else if (name == "pie") c.policy = AQMPolicy::PIE;
+    else throw std::invalid_argument("Unknown AQM policy: " + name);
+    if (colon == std::string::npos) return c;
+
+    std::stringstream list(spec.substr(colon + 1));
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        size_t eq = item.find('=');
+        std::string key = item.substr(0, eq);
+        double value = 0.0;
+        try {
+            size_t used = 0;
+            if (eq == std::string::npos) throw std::invalid_argument(item);
+            value = std::stod(item.substr(eq + 1), &used);
+            if (eq + 1 + used != item.size() || !(value > 0.0)) throw std::invalid_argument(item);
+        } catch (const std::exception&) {
+            throw std::invalid_argument("Invalid AQM parameter: " + item);
+        }
+
+        if (c.policy == AQMPolicy::RED && key == "min") c.redMinThreshold = value;
+        else if (c.policy == AQMPolicy::RED && key == "max") c.redMaxThreshold = value;
+        else if (c.policy == AQMPolicy::RED && key == "p") c.redMaxProbability = std::min(value, 1.0);
+        else if (c.policy == AQMPolicy::RED && key == "w") c.redWeight = std::min(value, 1.0);
+        else if (c.policy != AQMPolicy::RED && key == "target") c.target = value;
+        else if (c.policy == AQMPolicy::CODEL && key == "interval") c.interval = value;
+        else if (c.policy == AQMPolicy::PIE && key == "update") c.pieUpdate = value;
+        else if (c.policy == AQMPolicy::PIE && key == "alpha") c.pieAlpha = value;
+        else if (c.policy == AQMPolicy::PIE && key == "beta") c.pieBeta = value;
+        else if (c.policy == AQMPolicy::PIE && key == "burst") c.pieMaxBurst = value;
+        else throw std::invalid_argument("Unknown " + name + " parameter: " + key);
+    }
+    return c;
+}
+
+inline AQMPoint parseAQMPoint(const std::string& name) {
+    if (name == "enqueue") return AQMPoint::ENQUEUE;
+    if (name == "dequeue") return AQMPoint::DEQUEUE;
+    throw std::invalid_argument("Unknown AQM point: " + name);
+}
+
+/// @brief One early-drop controller with its per-link state.
+class AQMStage {
+private:
+    AQMConfig cfg;
+    bool onEnqueue = false;
+    bool onDequeue = false;
+    double bufferSize = 0.0;     // Packets
+    double minThreshold = 0.0;
+    double maxThreshold = 0.0;
+    double target = 0.0;
+    double meanPacketTime = 0.0; // Seconds to send an average-size packet
+    double mtu = 0.0;            // Largest packet, in bytes
+    uint64_t drops = 0;
+
+    // RED: EWMA of the queue length and packets since the last drop
+    double average = 0.0;
+    double lastDecision = 0.0; // Also when PIE last took a delay signal
+    long sinceDrop = -1;
+
+    // CoDel
+    bool dropping = false;
+    double firstAbove = 0.0; // When the delay has been above target for an interval
+    double dropNext = 0.0;
+    uint32_t codelCount = 0;
+    uint32_t lastCount = 0;
+
+    // PIE
+    double probability = 0.0;
+    double delay = 0.0;      // Latest delay signal
+    double delayOld = 0.0;   // Delay at the previous update
+    double heldBytes = 0.0;  // Backlog left by the latest decision
+    double nextUpdate = 0.0;
+    double burstAllowance = 0.0;
+
+    bool redDrop(double now, size_t queueLength, RandomSource& rng) {
+        if (queueLength > 0) {
+            average += cfg.redWeight * (queueLength - average);
+        } else {
+            // Idle correction: decay as if empty-queue samples had been
+            // taken once per packet time since the last decision
+            average *= std::pow(1.0 - cfg.redWeight, (now - lastDecision) / meanPacketTime);
+        }
+        lastDecision = now;
+
+        if (average < minThreshold) {
+            sinceDrop = -1;
+            return false;
+        }
+        if (average >= maxThreshold) {
+            sinceDrop = 0;
+            return true;
+        }
+        // Uniformize inter-drop gaps: p_a = p_b / (1 - count * p_b)
+        ++sinceDrop;
+        double pb = cfg.redMaxProbability * (average - minThreshold) / (maxThreshold - minThreshold);
+        double pa = sinceDrop * pb < 1.0 ? pb / (1.0 - sinceDrop * pb) : 1.0;
+        if (rng.uniform() < pa) {
+            sinceDrop = 0;
+            return true;
+        }
+        return false;
+    }
+
+    double controlLaw(double t) const { return t + cfg.interval / std::sqrt(static_cast<double>(codelCount)); }
+
+    bool codelDrop(double now, double sojourn, double queuedBytes) {
+        // ok_to_drop: delay has stayed above target for a whole interval
+        bool above = false;
+        if (sojourn < target || queuedBytes <= mtu) {
+            firstAbove = 0.0;
+        } else if (firstAbove == 0.0) {
+            firstAbove = now + cfg.interval;
+        } else {
+            above = now >= firstAbove;
+        }
+
+        if (dropping) {
+            if (!above) {
+                dropping = false;
+                return false;
+            }
+            if (now < dropNext) return false;
+            ++codelCount;
+            dropNext = controlLaw(dropNext);
+            return true;
+        }
+        if (!above) return false;
+
+        // Enter the dropping state, resuming near the previous drop rate if
+        // it was left only recently
+        dropping = true;
+        uint32_t delta = codelCount - lastCount;
+        codelCount = (delta > 1 && now - dropNext < 16 * cfg.interval) ? delta : 1;
+        lastCount = codelCount;
+        dropNext = controlLaw(now);
+        return true;
+    }
+
+    void pieUpdateProbability() {
+        double p = cfg.pieAlpha * (delay - target) + cfg.pieBeta * (delay - delayOld);
+        // Scale steps down while the probability is small (RFC 8033, 4.2)
+        if (probability < 0.000001) p /= 2048;
+        else if (probability < 0.00001) p /= 512;
+        else if (probability < 0.0001) p /= 128;
+        else if (probability < 0.001) p /= 32;
+        else if (probability < 0.01) p /= 8;
+        else if (probability < 0.1) p /= 2;
+        else if (p > 0.02) p = 0.02;
+        probability += p;
+        if (delay == 0.0 && delayOld == 0.0) probability *= 0.98;
+        probability = std::min(1.0, std::max(0.0, probability));
+        delayOld = delay;
+
+        burstAllowance = std::max(0.0, burstAllowance - cfg.pieUpdate);
+        if (probability == 0.0 && delay < target / 2) burstAllowance = cfg.pieMaxBurst;
+    }
+
+    bool pieDrop(double now, double queueDelay, double queuedBytes, RandomSource& rng) {
+        // Catch up on the periodic updates missed since the last decision.
+        // At enqueue the link went on draining the backlog the last arrival
+        // saw, one second of delay per second, so each update sees that
+        // delay less the time since (an estimate that ignores the residual
+        // service of the packet on the link). At dequeue no packet left in
+        // between, so the delay held steady, or was zero once the queue had
+        // drained. Skip ahead when nothing would change.
+        double signal = delay;
+        while (now >= nextUpdate) {
+            if (onEnqueue) delay = std::max(0.0, signal - (nextUpdate - lastDecision));
+            double before = probability, allowance = burstAllowance;
+            pieUpdateProbability();
+            nextUpdate += cfg.pieUpdate;
+            if (!onEnqueue && heldBytes == 0.0) delay = 0.0;
+            if (probability == before && burstAllowance == allowance && delayOld == delay && now >= nextUpdate) {
+                nextUpdate += std::floor((now - nextUpdate) / cfg.pieUpdate + 1.0) * cfg.pieUpdate;
+            }
+        }
+        lastDecision = now;
+        delay = queueDelay;
+        heldBytes = queuedBytes;
+
+        if (burstAllowance > 0.0) return false;
+        if (delayOld < target / 2 && probability < 0.2) return false;
+        if (queuedBytes <= 2 * mtu) return false;
+        return rng.uniform() < probability;
+    }
+
+public:
+    /// @brief Takes the link facts the controllers scale with.
+    void configure(const Config& config) {
+        bufferSize = static_cast<double>(config.bufferSize);
+        double sizeSum = 0.0;
+        mtu = 0.0;
+        for (size_t i = 0; i < config.sources.size(); ++i) {
+            sizeSum += meanPacketSize(config, i);
+            mtu = std::max(mtu, static_cast<double>(config.sources[i].maxSize));
+        }
+        double meanSize = config.sources.empty() ? 1.0 : std::max(1.0, sizeSum / config.sources.size());
+        meanPacketTime = meanSize / config.linkCapacity;
+    }
+
+    /// @brief Selects the controller; takes effect at the next reset().
+    void select(const AQMConfig& aqm) {
+        cfg = aqm;
+        AQMPoint usual = aqm.policy == AQMPolicy::CODEL ? AQMPoint::DEQUEUE : AQMPoint::ENQUEUE;
+        AQMPoint point = aqm.pointSet ? aqm.point : usual;
+        onEnqueue = aqm.policy != AQMPolicy::NONE && point == AQMPoint::ENQUEUE;
+        onDequeue = aqm.policy != AQMPolicy::NONE && point == AQMPoint::DEQUEUE;
+    }
+
+    /// @brief Clears the controller state at the start of a run.
+    void reset() {
+        minThreshold = cfg.redMinThreshold > 0 ? cfg.redMinThreshold : 0.25 * bufferSize;
+        maxThreshold = cfg.redMaxThreshold > 0 ? cfg.redMaxThreshold : 0.75 * bufferSize;
+        if (!(maxThreshold > minThreshold)) maxThreshold = minThreshold + 1.0;
+        target = cfg.target > 0 ? cfg.target : (cfg.policy == AQMPolicy::PIE ? 0.015 : 0.005);
+
+        drops = 0;
+        average = lastDecision = 0.0;
+        sinceDrop = -1;
+        dropping = false;
+        firstAbove = dropNext = 0.0;
+        codelCount = lastCount = 0;
+        probability = delay = delayOld = heldBytes = 0.0;
+        nextUpdate = cfg.pieUpdate;
+        burstAllowance = cfg.pieMaxBurst;
+    }
+
+    AQMPolicy policy() const { return cfg.policy; }
+    bool atEnqueue() const { return onEnqueue; }
+    bool atDequeue() const { return onDequeue; }
+
+    /// @brief Packets dropped by the controller in the last run.
+    uint64_t earlyDrops() const { return drops; }
+
+    /// @brief Checkpoint support: the controller state that reset() clears.
+    void saveState(StateWriter& out) const {
+        out.put(drops, average, lastDecision, sinceDrop);
+        out.put(dropping, firstAbove, dropNext, codelCount, lastCount);
+        out.put(probability, delay, delayOld, heldBytes, nextUpdate, burstAllowance);
+    }
+
+    void loadState(StateReader& in) {
+        in.get(drops, average, lastDecision, sinceDrop);
+        in.get(dropping, firstAbove, dropNext, codelCount, lastCount);
+        in.get(probability, delay, delayOld, heldBytes, nextUpdate, burstAllowance);
+    }
+
+    /**
+     * @brief Decides whether to drop the packet at hand.
+     * @param queueDelay   Delay signal in seconds (see the file comment).
+     * @param queueLength  Packets buffered, excluding the one at hand.
+     * @param queuedBytes  Bytes buffered, excluding the one at hand.
+     */
+    bool shouldDrop(double now, double queueDelay, size_t queueLength, double queuedBytes, RandomSource& rng) {
+        bool drop = false;
+        switch (cfg.policy) {
+            case AQMPolicy::RED: drop = redDrop(now, queueLength, rng); break;
+            case AQMPolicy::CODEL: drop = codelDrop(now, queueDelay, queuedBytes); break;
+            case AQMPolicy::PIE: drop = pieDrop(now, queueDelay, queuedBytes, rng); break;
+            case AQMPolicy::NONE: break;
+        }
+        if (drop) ++drops;
+        return drop;
+    }
+};
+
+#endif // SIM_AQM_H
@@ -0,0 +1,294 @@
+/**
+ * @file arrivals.h
+ * @brief Arrival streams feeding the event engine.
+ * By default every source owns its own Poisson arrival chain. In aggregated
+ * mode, sources that share the same activity window are merged into one
+ * superposed Poisson process at the summed rate, and each arrival is
+ * attributed to a member source by weighted sampling. This keeps a single
+ * pending arrival per window instead of one per source.
+ *
+ * Every arrival lane (an ArrivalStream, or a trace replay, see replay.h) is
+ * a lazy generator: it holds only its next arrival and produces the one
+ * after when that is taken. The engine keeps exactly one pending event per
+ * lane, at the lane's head time, so the event queue performs the k-way
+ * merge of all lanes and holds O(lanes) arrival events however many
+ * packets they produce.
+ *
+ * A stream is Poisson unless its source's TrafficModel says otherwise. On/off
+ * and MMPP streams run the modulating two-state chain lazily alongside the
+ * arrivals: a gap that would cross the end of the current state is dropped
+ * and redrawn from the start of the next one, which is exact because the
+ * exponential gap is memoryless. Pareto gaps are xm exp(E / alpha) for a
+ * standard exponential E, the inverse CDF with its constants precomputed.
+ * Empirical sizes are drawn through an alias table. Only Poisson sources are
+ * superposed in aggregated mode. A generator provides:
+ *   bool start();                             // Positions the first arrival; false if none
+ *   double headTime() const;                  // Time of the pending arrival
+ *   template <class Random>
+ *   bool take(Random& rng, Arrival& out);     // Consumes it; false if no arrival follows
+ */
+
+#ifndef SIM_ARRIVALS_H
+#define SIM_ARRIVALS_H
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <utility>
+#include <cmath>
+#include <cstdint>
+
+#include "config.h"
+#include "checkpoint.h"
+
+/**
+ * @brief Walker/Vose alias table for O(1) sampling from a discrete distribution.
+ */
+class AliasTable {
+private:
+    std::vector<double> probability;
+    std::vector<uint32_t> alias;
+
+public:
+    void build(const std::vector<double>& weights) {
+        size_t n = weights.size();
+        probability.assign(n, 1.0);
+        alias.assign(n, 0);
+        if (n == 0) return;
+
+        double total = 0.0;
+        for (double w : weights) total += w;
+
+        std::vector<double> scaled(n);
+        std::vector<uint32_t> small, large;
+        for (size_t i = 0; i < n; ++i) {
+            scaled[i] = weights[i] * n / total;
+            if (scaled[i] < 1.0) small.push_back(static_cast<uint32_t>(i));
+            else large.push_back(static_cast<uint32_t>(i));
+        }
+
+        while (!small.empty() && !large.empty()) {
+            uint32_t s = small.back(); small.pop_back();
+            uint32_t l = large.back(); large.pop_back();
+            probability[s] = scaled[s];
+            alias[s] = l;
+            scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+            if (scaled[l] < 1.0) small.push_back(l);
+            else large.push_back(l);
+        }
+        // Leftovers are 1.0 up to rounding
+        for (uint32_t i : small) probability[i] = 1.0;
+        for (uint32_t i : large) probability[i] = 1.0;
+    }
+
+    size_t size() const { return probability.size(); }
+
+    /// @brief Maps a U[0, 1) variate to an index.
+    uint32_t sample(double unit) const {
+        double u = unit * probability.size();
+        uint32_t column = static_cast<uint32_t>(u);
+        if (column >= probability.size()) column = static_cast<uint32_t>(probability.size() - 1);
+        return (u - column) < probability[column] ? column : alias[column];
+    }
+};
+
+/// @brief Empirical packet size law of a source, sampled in O(1).
+struct EmpiricalSizes {
+    std::vector<int> sizes;
+    AliasTable picker;
+
+    explicit EmpiricalSizes(const SizeTable& table) : sizes(table.sizes) { picker.build(table.weights); }
+
+    int sample(double unit) const { return sizes[picker.sample(unit)]; }
+};
+
+/// @brief A packet produced by an arrival lane.
+struct Arrival {
+    int source;
+    int size; // Bytes
+};
+
+/// @brief Inclusive packet size range of a source.
+struct SizeRange {
+    int minSize;
+    int maxSize;
+};
+
+/// @brief One arrival chain: a single source, or a superposed group of Poisson sources.
+struct ArrivalStream {
+    // Read on every arrival; kept together at the front so take() touches
+    // one cache line in the common single-source case
+    double head = 0.0;             // Time of the pending arrival
+    double endTime;
+    double meanGap;                // 1 / aggregate rate; scales a standard exponential
+    int source;                    // Sole member, or -1 when the source is sampled
+    SizeRange sizes;               // Of the sole member
+    ArrivalProcess process = ArrivalProcess::POISSON;
+    std::shared_ptr<const EmpiricalSizes> table; // Of the sole member; null draws uniform sizes
+
+    double startTime;
+    std::vector<int> members;      // Source IDs of a superposed group
+    std::vector<SizeRange> memberSizes;
+    std::vector<std::shared_ptr<const EmpiricalSizes>> memberTables; // Empty when all are uniform
+    AliasTable picker;
+
+    // On/off and MMPP: the modulating chain, in state 0 when the source turns on
+    int state = 0;
+    double phaseEnd = -1.0;        // End of the current state; drawn at the first take()
+    double stateGap[2] = {0.0, 0.0}; // Mean gap in each state; 0 = silent
+    double holdMean[2] = {0.0, 0.0};
+    // Pareto: gap = paretoScale exp(E paretoExponent)
+    double paretoScale = 0.0;
+    double paretoExponent = 0.0;
+
+    ArrivalStream(double start, double end, double rate, int src, SizeRange range)
+        : endTime(end), meanGap(1.0 / rate), source(src), sizes(range), startTime(start) {}
+
+    /// @brief Switches a single-source stream to `model`'s arrival process and sizes.
+    void setModel(const TrafficModel& model, std::shared_ptr<const EmpiricalSizes> sizeTable) {
+        process = model.process;
+        table = sizeTable;
+        const double* p = model.param;
+        if (process == ArrivalProcess::PARETO) {
+            paretoScale = meanGap * (p[0] - 1.0) / p[0];
+            paretoExponent = 1.0 / p[0];
+        } else if (process == ArrivalProcess::ON_OFF || process == ArrivalProcess::MMPP) {
+            bool onOff = process == ArrivalProcess::ON_OFF;
+            stateGap[0] = meanGap;
+            stateGap[1] = onOff || p[0] <= 0.0 ? 0.0 : 1.0 / p[0];
+            holdMean[0] = onOff ? p[0] : p[1];
+            holdMean[1] = onOff ? p[1] : p[2];
+        }
+    }
+
+    bool start() {
+        head = startTime;
+        state = 0;
+        phaseEnd = -1.0;
+        return true;
+    }
+
+    double headTime() const { return head; }
+
+    template <class Random>
+    bool take(Random& rng, Arrival& out) {
+        // Draw order (source, gap, size) is part of the reproducible stream
+        SizeRange range = sizes;
+        const EmpiricalSizes* empirical = table.get();
+        if (source >= 0) {
+            out.source = source;
+        } else {
+            uint32_t m = picker.sample(rng.uniform());
+            out.source = members[m];
+            range = memberSizes[m];
+            if (!memberTables.empty()) empirical = memberTables[m].get();
+        }
+        if (process == ArrivalProcess::POISSON) {
+            head += rng.exponential() * meanGap;
+        } else if (process == ArrivalProcess::PARETO) {
+            head += paretoScale * std::exp(rng.exponential() * paretoExponent);
+        } else {
+            modulatedGap(rng);
+        }
+        out.size = empirical ? empirical->sample(rng.uniform()) : rng.uniformInt(range.minSize, range.maxSize);
+        return head < endTime;
+    }
+
+    void saveState(StateWriter& out) const {
+        out.put(head, state, phaseEnd);
+    }
+
+    void loadState(StateReader& in) {
+        in.get(head, state, phaseEnd);
+    }
+
+private:
+    /// @brief Moves head to the next arrival of the modulated process, or past endTime.
+    template <class Random>
+    void modulatedGap(Random& rng) {
+        if (phaseEnd < 0.0) phaseEnd = head + rng.exponential() * holdMean[0];
+        double t = head;
+        for (;;) {
+            double gap = stateGap[state] > 0.0 ? rng.exponential() * stateGap[state] : HUGE_VAL;
+            if (t + gap < phaseEnd) {
+                head = t + gap;
+                return;
+            }
+            t = phaseEnd;
+            if (t >= endTime) {
+                head = t;
+                return;
+            }
+            state ^= 1;
+            phaseEnd = t + rng.exponential() * holdMean[state];
+        }
+    }
+};
+
+/**
+ * @brief Builds the arrival streams for a set of sources.
+ * @param aggregate When false, returns one stream per source. When true,
+ *        sources with identical [startTime, endTime) windows are merged.
+ */
+template <class SourceT>
+std::vector<ArrivalStream> buildArrivalStreams(const std::vector<SourceT>& sources, bool aggregate) {
+    std::vector<ArrivalStream> streams;
+    if (!aggregate) {
+        streams.reserve(sources.size());
+        for (const auto& src : sources) {
+            streams.emplace_back(src.startTime, src.endTime, src.packetRate, src.id,
+                                 SizeRange{src.minSize, src.maxSize});
+            streams.back().setModel(src.traffic, src.sizeTable);
+        }
+        return streams;
+    }
+
+    // Group Poisson sources by activity window, in order of first appearance
+    std::map<std::pair<double, double>, size_t> groupOf;
+    std::vector<std::vector<int>> groups;
+    for (const auto& src : sources) {
+        if (src.packetRate <= 0.0) continue;
+        if (src.traffic.process != ArrivalProcess::POISSON) {
+            streams.emplace_back(src.startTime, src.endTime, src.packetRate, src.id,
+                                 SizeRange{src.minSize, src.maxSize});
+            streams.back().setModel(src.traffic, src.sizeTable);
+            continue;
+        }
+        auto key = std::make_pair(src.startTime, src.endTime);
+        auto it = groupOf.find(key);
+        if (it == groupOf.end()) {
+            it = groupOf.insert(std::make_pair(key, groups.size())).first;
+            groups.push_back(std::vector<int>());
+        }
+        groups[it->second].push_back(src.id);
+    }
+
+    for (const auto& group : groups) {
+        std::vector<double> rates;
+        std::vector<SizeRange> sizes;
+        std::vector<std::shared_ptr<const EmpiricalSizes>> tables;
+        bool empirical = false;
+        double totalRate = 0.0;
+        for (int id : group) {
+            rates.push_back(sources[id].packetRate);
+            sizes.push_back(SizeRange{sources[id].minSize, sources[id].maxSize});
+            tables.push_back(sources[id].sizeTable);
+            empirical = empirical || sources[id].sizeTable;
+            totalRate += sources[id].packetRate;
+        }
+        const auto& first = sources[group[0]];
+        if (group.size() == 1) {
+            streams.emplace_back(first.startTime, first.endTime, totalRate, first.id, sizes[0]);
+            streams.back().table = tables[0];
+        } else {
+            streams.emplace_back(first.startTime, first.endTime, totalRate, -1, sizes[0]);
+            streams.back().members = group;
+            streams.back().memberSizes = sizes;
+            if (empirical) streams.back().memberTables = tables;
+            streams.back().picker.build(rates);
+        }
+    }
+    return streams;
+}
+
+#endif // SIM_ARRIVALS_H
@@ -0,0 +1,151 @@
+/**
+ * @file checkpoint.h
+ * @brief Binary snapshot streams for checkpointing a simulation.
+ * Every stateful component writes what configure() does not rebuild through
+ * saveState(StateWriter&) and reads it back with loadState(StateReader&),
+ * in the same order. Values are stored in host layout; arrays are a count
+ * followed by their raw elements, so saving and restoring large buffers is
+ * a memcpy. A snapshot starts with a CheckpointHeader.
+ */
+
+#ifndef SIM_CHECKPOINT_H
+#define SIM_CHECKPOINT_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/// @brief Leading block of a snapshot; payloadBytes of component state follow.
+struct CheckpointHeader {
+    char magic[8];         // "PKTCHKPT"
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t payloadBytes;
+};
+
+static_assert(sizeof(CheckpointHeader) == 24, "CheckpointHeader layout is part of the file format");
+
+static const char kCheckpointMagic[8] = {'P', 'K', 'T', 'C', 'H', 'K', 'P', 'T'};
+static const uint32_t kCheckpointVersion = 3;
+
+/// @brief Appends component state to an in-memory snapshot.
+class StateWriter {
+private:
+    std::string bytes;
+
+public:
+    StateWriter() {
+        CheckpointHeader h;
+        std::memset(&h, 0, sizeof(h));
+        std::memcpy(h.magic, kCheckpointMagic, sizeof(h.magic));
+        h.version = kCheckpointVersion;
+        bytes.append(reinterpret_cast<const char*>(&h), sizeof(h));
+    }
+
+    void put() {}
+
+    template <class T, class... Rest>
+    void put(const T& value, const Rest&... rest) {
+        static_assert(std::is_trivially_copyable<T>::value, "put() stores raw bytes");
+        bytes.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        put(rest...);
+    }
+
+    template <class T, class Alloc>
+    void putVector(const std::vector<T, Alloc>& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "putVector() stores raw bytes");
+        put(static_cast<uint64_t>(v.size()));
+        if (!v.empty()) bytes.append(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(T));
+    }
+
+    void putString(const std::string& s) {
+        put(static_cast<uint64_t>(s.size()));
+        bytes.append(s);
+    }
+
+    /// @brief Completes the header and hands over the snapshot.
+    std::string finish() {
+        uint64_t payload = bytes.size() - sizeof(CheckpointHeader);
+        std::memcpy(&bytes[offsetof(CheckpointHeader, payloadBytes)], &payload, sizeof(payload));
+        return std::move(bytes);
+    }
+};
+
+/// @brief Reads component state back out of a snapshot in writing order.
+class StateReader {
+private:
+    const char* cursor;
+    const char* end;
+
+    const char* take(size_t n) {
+        if (static_cast<size_t>(end - cursor) < n) throw std::runtime_error("Truncated checkpoint");
+        const char* at = cursor;
+        cursor += n;
+        return at;
+    }
+
+public:
+    StateReader(const char* data, size_t size) : cursor(data), end(data + size) {
+        CheckpointHeader h;
+        std::memcpy(&h, take(sizeof(h)), sizeof(h));
+        if (std::memcmp(h.magic, kCheckpointMagic, sizeof(h.magic)) != 0 || h.version != kCheckpointVersion) {
+            throw std::runtime_error("Not a version " + std::to_string(kCheckpointVersion) + " checkpoint");
+        }
+        if (h.payloadBytes > static_cast<uint64_t>(end - cursor)) throw std::runtime_error("Truncated checkpoint");
+        end = cursor + h.payloadBytes;
+    }
+
+    void get() {}
+
+    template <class T, class... Rest>
+    void get(T& value, Rest&... rest) {
+        static_assert(std::is_trivially_copyable<T>::value, "get() loads raw bytes");
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        get(rest...);
+    }
+
+    template <class T, class Alloc>
+    void getVector(std::vector<T, Alloc>& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "getVector() loads raw bytes");
+        uint64_t n = 0;
+        get(n);
+        if (n > static_cast<uint64_t>(end - cursor) / sizeof(T)) throw std::runtime_error("Truncated checkpoint");
+        v.resize(static_cast<size_t>(n));
+        if (n > 0) std::memcpy(v.data(), take(static_cast<size_t>(n) * sizeof(T)), static_cast<size_t>(n) * sizeof(T));
+    }
+
+    /// @brief As getVector(), for arrays whose length the configuration fixes.
+    template <class T, class Alloc>
+    void getVector(std::vector<T, Alloc>& v, size_t expected) {
+        getVector(v);
+        if (v.size() != expected) throw std::runtime_error("Checkpoint does not match the configured scenario");
+    }
+
+    std::string getString() {
+        uint64_t n = 0;
+        get(n);
+        if (n > static_cast<uint64_t>(end - cursor)) throw std::runtime_error("Truncated checkpoint");
+        return std::string(take(static_cast<size_t>(n)), static_cast<size_t>(n));
+    }
+
+    /// @brief Bytes left; bounds counts read from the snapshot before allocating.
+    size_t remaining() const { return static_cast<size_t>(end - cursor); }
+    bool atEnd() const { return cursor == end; }
+};
+
+/**
+ * @brief Name of the event queue a Simulator snapshot was taken with. A
+ * snapshot opens with the discipline name and then the event queue name.
+ */
+inline std::string checkpointEventQueue(const std::string& snapshot) {
+    StateReader in(snapshot.data(), snapshot.size());
+    in.getString();
+    return in.getString();
+}
+
+#endif // SIM_CHECKPOINT_H
@@ -0,0 +1,586 @@
+/**
+ * @file config.h
+ * @brief Scenario configuration shared by every scheduling discipline.
+ * Loads either the text input format described in the README or its
+ * compiled binary form into a plain Config that can be handed to any
+ * Simulator instantiation. The text parser reads the mapped file line by
+ * line without per-line allocation. A compiled scenario is a fixed header
+ * followed by the SourceConfig records as laid out in memory, so loading it
+ * is one copy out of the mapping. Both paths validate every source and name
+ * the offending line or source index in their errors.
+ *
+ * A source line may end with optional traffic fields that replace its
+ * Poisson arrivals (onoff, pareto, mmpp) or its uniform sizes (sizes). They
+ * are kept beside the fixed SourceConfig records in Config::traffic, which
+ * stays empty for plain scenarios.
+ */
+
+#ifndef SIM_CONFIG_H
+#define SIM_CONFIG_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#include <map>
+#include <climits>
+#include <cmath>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "mapped_file.h"
+
+/// @brief Per-source parameters exactly as they appear in the input file.
+struct SourceConfig {
+    double packetRate;    // Packets per second
+    int minSize;          // Bytes
+    int maxSize;          // Bytes
+    double weight;
+    double startFraction; // Fraction of simulationTime at which the source turns on
+    double endFraction;   // Fraction of simulationTime at which the source turns off
+};
+
+/// @brief How a source spaces its packets.
+enum class ArrivalProcess : int32_t { POISSON, ON_OFF, PARETO, MMPP, FLOWS };
+
+/**
+ * @brief Arrival process and size law of one source. `param` by process:
+ *   ON_OFF  mean on and off periods, seconds, both exponential; Poisson at
+ *           PACKET_RATE while on
+ *   PARETO  shape alpha > 1 of Pareto gaps with mean 1 / PACKET_RATE
+ *   MMPP    two-state Markov-modulated Poisson: PACKET_RATE in state 0 and
+ *           param[0] in state 1, mean holding times param[1] and param[2] s
+ *   FLOWS   a flow class for the flow engine (flows.h): flows start as a
+ *           Poisson process at param[0] per second and each sends a
+ *           geometric number of packets, mean param[1], at PACKET_RATE
+ * On/off and MMPP sources start in the state PACKET_RATE belongs to.
+ */
+struct TrafficModel {
+    ArrivalProcess process = ArrivalProcess::POISSON;
+    int32_t sizeTable = -1;  // Index into Config::sizeTables; -1 = uniform over [MIN_SIZE, MAX_SIZE]
+    double param[3] = {0.0, 0.0, 0.0};
+};
+
+/// @brief Empirical packet size law, e.g. IMIX: sizes and their relative weights.
+struct SizeTable {
+    std::vector<int> sizes;
+    std::vector<double> weights;
+
+    bool operator==(const SizeTable& other) const { return sizes == other.sizes && weights == other.weights; }
+};
+
+/// @brief Global link parameters plus the list of traffic sources.
+struct Config {
+    int numSources = 0;
+    double simulationTime = 0.0;
+    double linkCapacity = 0.0; // Bytes per second
+    size_t bufferSize = 0;     // Packets
+    size_t bufferBytes = 0;    // Bytes, enforced alongside bufferSize; 0 = no byte limit
+    std::vector<SourceConfig> sources;
+    std::vector<TrafficModel> traffic;  // One per source, or empty when all are Poisson with uniform sizes
+    std::vector<SizeTable> sizeTables;
+};
+
+/// @brief Leading block of a compiled scenario file; sourceCount SourceConfig records follow.
+struct ScenarioHeader {
+    char magic[8];         // "PKTSCENE"
+    uint32_t version;
+    uint32_t recordSize;   // sizeof(SourceConfig)
+    uint64_t sourceCount;
+    double simulationTime;
+    double linkCapacity;
+    uint64_t bufferSize;
+    uint64_t bufferBytes;
+};
+
+static_assert(sizeof(ScenarioHeader) == 56, "ScenarioHeader layout is part of the file format");
+static_assert(sizeof(SourceConfig) == 40, "SourceConfig layout is part of the file format");
+static_assert(sizeof(TrafficModel) == 32, "TrafficModel layout is part of the file format");
+
+static const char kScenarioMagic[8] = {'P', 'K', 'T', 'S', 'C', 'E', 'N', 'E'};
+static const uint32_t kScenarioVersion = 2; // Version 1 files, without traffic models, still load
+
+/// @brief The traffic model of source `i`; Poisson with uniform sizes unless set.
+inline TrafficModel trafficModel(const Config& config, size_t i) {
+    return i < config.traffic.size() ? config.traffic[i] : TrafficModel();
+}
+
+/// @brief True when every source is a Poisson process, whatever its sizes.
+inline bool poissonArrivals(const Config& config) {
+    for (const auto& model : config.traffic) {
+        if (model.process != ArrivalProcess::POISSON) return false;
+    }
+    return true;
+}
+
+/// @brief True when some source line is a flow class, which only the flow engine runs.
+inline bool hasFlowClasses(const Config& config) {
+    for (const auto& model : config.traffic) {
+        if (model.process == ArrivalProcess::FLOWS) return true;
+    }
+    return false;
+}
+
+/// @brief Long-run packets per second of source `i` while it is active.
+inline double meanPacketRate(const Config& config, size_t i) {
+    const SourceConfig& sc = config.sources[i];
+    TrafficModel model = trafficModel(config, i);
+    switch (model.process) {
+    case ArrivalProcess::ON_OFF:
+        return sc.packetRate * model.param[0] / (model.param[0] + model.param[1]);
+    case ArrivalProcess::MMPP:
+        return (sc.packetRate * model.param[1] + model.param[0] * model.param[2]) / (model.param[1] + model.param[2]);
+    case ArrivalProcess::FLOWS:
+        return model.param[0] * model.param[1];
+    default:
+        return sc.packetRate;
+    }
+}
+
+/// @brief Mean packet size of source `i`, bytes.
+inline double meanPacketSize(const Config& config, size_t i) {
+    const SourceConfig& sc = config.sources[i];
+    int table = trafficModel(config, i).sizeTable;
+    if (table < 0) return 0.5 * (sc.minSize + sc.maxSize);
+    const SizeTable& t = config.sizeTables[table];
+    double sum = 0.0, total = 0.0;
+    for (size_t k = 0; k < t.sizes.size(); ++k) {
+        sum += t.sizes[k] * t.weights[k];
+        total += t.weights[k];
+    }
+    return sum / total;
+}
+
+/// @brief What is wrong with a source's parameters, or null when they are usable.
+inline const char* sourceProblem(const SourceConfig& sc) {
+    if (!(sc.packetRate > 0) || std::isinf(sc.packetRate)) return "PACKET_RATE must be positive";
+    if (sc.minSize < 1) return "MIN_SIZE must be at least 1 byte";
+    if (sc.maxSize < sc.minSize) return "MAX_SIZE is below MIN_SIZE";
+    if (!(sc.weight >= 0) || std::isinf(sc.weight)) return "WEIGHT must be zero or positive";
+    if (!(sc.startFraction >= 0)) return "START_TIME_FRACTION must not be negative";
+    if (!(sc.endFraction >= sc.startFraction)) return "END_TIME_FRACTION is below START_TIME_FRACTION";
+    return nullptr;
+}
+
+/// @brief What is wrong with source `i`'s traffic model, or null when it is usable.
+inline const char* trafficProblem(const Config& config, size_t i) {
+    TrafficModel model = trafficModel(config, i);
+    const double* p = model.param;
+    switch (model.process) {
+    case ArrivalProcess::POISSON:
+        break;
+    case ArrivalProcess::ON_OFF:
+        if (!(p[0] > 0) || !(p[1] > 0) || std::isinf(p[0]) || std::isinf(p[1])) {
+            return "onoff periods must be positive";
+        }
+        break;
+    case ArrivalProcess::PARETO:
+        if (!(p[0] > 1) || std::isinf(p[0])) return "pareto shape must exceed 1";
+        break;
+    case ArrivalProcess::MMPP:
+        if (!(p[0] >= 0) || std::isinf(p[0])) return "mmpp RATE_1 must be zero or positive";
+        if (!(p[1] > 0) || !(p[2] > 0) || std::isinf(p[1]) || std::isinf(p[2])) {
+            return "mmpp holding times must be positive";
+        }
+        break;
+    case ArrivalProcess::FLOWS:
+        if (!(p[0] > 0) || std::isinf(p[0])) return "flows FLOW_RATE must be positive";
+        if (!(p[1] >= 1) || std::isinf(p[1])) return "flows MEAN_PACKETS must be at least 1";
+        break;
+    default:
+        return "unknown arrival process";
+    }
+    if (model.sizeTable >= 0) {
+        if (static_cast<size_t>(model.sizeTable) >= config.sizeTables.size()) return "unknown size table";
+        const SourceConfig& sc = config.sources[i];
+        const SizeTable& t = config.sizeTables[model.sizeTable];
+        double total = 0.0;
+        for (size_t k = 0; k < t.sizes.size(); ++k) {
+            if (t.sizes[k] < sc.minSize || t.sizes[k] > sc.maxSize) return "sizes entry outside [MIN_SIZE, MAX_SIZE]";
+            if (!(t.weights[k] >= 0) || std::isinf(t.weights[k])) return "sizes weight must be zero or positive";
+            total += t.weights[k];
+        }
+        if (!(total > 0)) return "sizes needs a positive weight";
+    }
+    return nullptr;
+}
+
+/// @brief What is wrong with the link parameters, or null when they are usable.
+inline const char* linkProblem(const Config& config) {
+    if (config.numSources < 0) return "NUM_SOURCES must not be negative";
+    if (!(config.simulationTime > 0) || std::isinf(config.simulationTime)) return "SIMULATION_TIME must be positive";
+    if (!(config.linkCapacity > 0) || std::isinf(config.linkCapacity)) return "LINK_CAPACITY must be positive";
+    return nullptr;
+}
+
+/// @brief Line and field cursor over a text scenario held in a mapped file.
+class ConfigTextReader {
+private:
+    const char* data;
+    size_t end;
+    size_t offset = 0;
+    std::string path;
+    int lineNumber = 0;
+    char buffer[512];
+    char* cursor = buffer;
+
+    template <class T>
+    static bool convert(const char* token, T& value);
+
+public:
+    ConfigTextReader(const MappedFile& file, const std::string& filename)
+        : data(file.data()), end(file.size()), path(filename) {}
+
+    /// @brief Moves to the next non-blank line; false at the end of the file.
+    bool nextLine() {
+        while (offset < end) {
+            const char* start = data + offset;
+            const char* stop = static_cast<const char*>(std::memchr(start, '\n', end - offset));
+            size_t length = stop ? static_cast<size_t>(stop - start) : end - offset;
+            offset += length + (stop ? 1 : 0);
+            ++lineNumber;
+
+            // strtod needs a terminated string and the mapping is not one
+            if (length >= sizeof(buffer)) fail(-1, "line is too long");
+            std::memcpy(buffer, start, length);
+            buffer[length] = '\0';
+            cursor = buffer;
+            if (!atEnd()) return true;
+        }
+        return false;
+    }
+
+    bool atEnd() {
+        while (*cursor == ' ' || *cursor == '\t' || *cursor == '\r') ++cursor;
+        return *cursor == '\0';
+    }
+
+    /**
+     * @brief Parses the next whitespace-separated field of the line into
+     * `value`. Returns false when the line has no more fields and throws
+     * when the field is not a valid `name`. `source` is the index of the
+     * source the line describes, or -1 for the header.
+     */
+    template <class T>
+    bool field(T& value, int source, const char* name) {
+        if (atEnd()) return false;
+        char* token = cursor;
+        while (*cursor != '\0' && *cursor != ' ' && *cursor != '\t' && *cursor != '\r') ++cursor;
+        char saved = *cursor;
+        *cursor = '\0';
+        if (!convert(token, value)) fail(source, std::string(name) + " '" + token + "' is not a valid number");
+        *cursor = saved;
+        return true;
+    }
+
+    /// @brief As field(), but a missing field is an error too.
+    template <class T>
+    void require(T& value, int source, const char* name) {
+        if (!field(value, source, name)) fail(source, std::string("missing ") + name);
+    }
+
+    int line() const { return lineNumber; }
+
+    [[noreturn]] void fail(int source, const std::string& what) const {
+        std::string at = path + ":" + std::to_string(lineNumber) + ": ";
+        if (source >= 0) at += "source " + std::to_string(source) + ": ";
+        throw std::runtime_error(at + what);
+    }
+};
+
+template <>
+inline bool ConfigTextReader::convert(const char* token, double& value) {
+    char* stop = nullptr;
+    value = std::strtod(token, &stop);
+    return stop != token && *stop == '\0';
+}
+
+template <>
+inline bool ConfigTextReader::convert(const char* token, int& value) {
+    char* stop = nullptr;
+    errno = 0;
+    long v = std::strtol(token, &stop, 10);
+    if (stop == token || *stop != '\0' || errno == ERANGE || v < INT_MIN || v > INT_MAX) return false;
+    value = static_cast<int>(v);
+    return true;
+}
+
+template <>
+inline bool ConfigTextReader::convert(const char* token, size_t& value) {
+    if (*token == '-') return false;
+    char* stop = nullptr;
+    errno = 0;
+    unsigned long long v = std::strtoull(token, &stop, 10);
+    if (stop == token || *stop != '\0' || errno == ERANGE) return false;
+    value = static_cast<size_t>(v);
+    return true;
+}
+
+template <>
+inline bool ConfigTextReader::convert(const char* token, std::string& value) {
+    value = token;
+    return true;
+}
+
+/// @brief Simple IMIX: 7 x 40 B, 4 x 576 B and 1 x 1500 B.
+static const char kImixSizes[] = "40:7,576:4,1500:1";
+
+/**
+ * @brief Parses a sizes list "<bytes>:<weight>,..." into `table`; null on
+ * success, otherwise what is wrong.
+ */
+inline const char* parseSizeTable(const std::string& spec, SizeTable& table) {
+    const char* p = spec == "imix" ? kImixSizes : spec.c_str();
+    while (*p != '\0') {
+        char* stop = nullptr;
+        errno = 0;
+        long size = std::strtol(p, &stop, 10);
+        if (stop == p || *stop != ':' || errno == ERANGE || size < 1 || size > INT_MAX) {
+            return "sizes entries must be <bytes>:<weight>";
+        }
+        p = stop + 1;
+        double weight = std::strtod(p, &stop);
+        if (stop == p || (*stop != ',' && *stop != '\0')) return "sizes entries must be <bytes>:<weight>";
+        table.sizes.push_back(static_cast<int>(size));
+        table.weights.push_back(weight);
+        p = *stop == ',' ? stop + 1 : stop;
+    }
+    if (table.sizes.empty()) return "sizes list is empty";
+    return nullptr;
+}
+
+/**
+ * @brief Reads the optional traffic fields at the end of source line `i`.
+ * Identical size lists share one table.
+ */
+inline void parseTrafficFields(ConfigTextReader& in, Config& config, int i,
+                               std::map<std::string, int>& tableOf) {
+    std::string keyword;
+    TrafficModel model;
+    bool processSet = false;
+    while (in.field(keyword, i, "traffic field")) {
+        if (keyword == "sizes") {
+            std::string spec;
+            in.require(spec, i, "sizes list");
+            if (model.sizeTable >= 0) in.fail(i, "sizes given twice");
+            auto it = tableOf.find(spec);
+            if (it == tableOf.end()) {
+                SizeTable table;
+                if (const char* problem = parseSizeTable(spec, table)) in.fail(i, problem);
+                it = tableOf.insert(std::make_pair(spec, static_cast<int>(config.sizeTables.size()))).first;
+                config.sizeTables.push_back(table);
+            }
+            model.sizeTable = it->second;
+            continue;
+        }
+        if (processSet) in.fail(i, "more than one arrival process");
+        processSet = true;
+        if (keyword == "onoff") {
+            model.process = ArrivalProcess::ON_OFF;
+            in.require(model.param[0], i, "ON_MEAN");
+            in.require(model.param[1], i, "OFF_MEAN");
+        } else if (keyword == "pareto") {
+            model.process = ArrivalProcess::PARETO;
+            in.require(model.param[0], i, "SHAPE");
+        } else if (keyword == "flows") {
+            model.process = ArrivalProcess::FLOWS;
+            in.require(model.param[0], i, "FLOW_RATE");
+            in.require(model.param[1], i, "MEAN_PACKETS");
+        } else if (keyword == "mmpp") {
+            model.process = ArrivalProcess::MMPP;
+            in.require(model.param[0], i, "RATE_1");
+            in.require(model.param[1], i, "HOLD_0");
+            in.require(model.param[2], i, "HOLD_1");
+        } else if (keyword != "poisson") {
+            in.fail(i, "unknown traffic field '" + keyword + "'");
+        }
+    }
+    if (model.process == ArrivalProcess::POISSON && model.sizeTable < 0) return;
+    config.traffic.resize(config.sources.size());
+    config.traffic[i] = model;
+}
+
+/**
+ * @brief Parses the text input format out of an already mapped file.
+ */
+inline Config parseTextConfig(const MappedFile& file, const std::string& filename) {
+    ConfigTextReader in(file, filename);
+    Config config;
+    if (!in.nextLine()) throw std::runtime_error("Empty config file: " + filename);
+
+    in.require(config.numSources, -1, "NUM_SOURCES");
+    in.require(config.simulationTime, -1, "SIMULATION_TIME");
+    in.require(config.linkCapacity, -1, "LINK_CAPACITY");
+    in.require(config.bufferSize, -1, "BUFFER_SIZE");
+    if (!in.field(config.bufferBytes, -1, "BUFFER_BYTES")) config.bufferBytes = 0; // Optional fifth field
+    if (const char* problem = linkProblem(config)) in.fail(-1, problem);
+    int headerLine = in.line();
+
+    // A source line takes at least 12 bytes, which bounds a bogus NUM_SOURCES
+    config.sources.reserve(std::min<size_t>(config.numSources, file.size() / 12 + 1));
+    std::map<std::string, int> tableOf;
+    for (int i = 0; i < config.numSources; ++i) {
+        if (!in.nextLine()) {
+            throw std::runtime_error(filename + ": source " + std::to_string(i) + " missing; line " +
+                                     std::to_string(headerLine) + " declares " + std::to_string(config.numSources) +
+                                     " sources but the file has " + std::to_string(i));
+        }
+        config.sources.push_back(SourceConfig());
+        SourceConfig& src = config.sources.back();
+        in.require(src.packetRate, i, "PACKET_RATE");
+        in.require(src.minSize, i, "MIN_SIZE");
+        in.require(src.maxSize, i, "MAX_SIZE");
+        in.require(src.weight, i, "WEIGHT");
+        in.require(src.startFraction, i, "START_TIME_FRACTION");
+        in.require(src.endFraction, i, "END_TIME_FRACTION");
+        if (const char* problem = sourceProblem(src)) in.fail(i, problem);
+        parseTrafficFields(in, config, i, tableOf);
+        if (const char* problem = trafficProblem(config, i)) in.fail(i, problem);
+    }
+    if (!config.traffic.empty()) config.traffic.resize(config.sources.size());
+    return config;
+}
+
+/**
+ * @brief Loads a compiled scenario out of an already mapped file. The
+ * records are copied out of the mapping as they are; nothing is parsed.
+ * Version 2 follows them with a traffic section: a count (0 or one per
+ * source) of TrafficModel records, then a count of size tables, each an
+ * entry count, its int32 sizes and its double weights.
+ */
+inline Config parseBinaryConfig(const MappedFile& file, const std::string& filename) {
+    if (file.size() < sizeof(ScenarioHeader)) throw std::runtime_error("Truncated scenario header in " + filename);
+    ScenarioHeader h;
+    std::memcpy(&h, file.data(), sizeof(h));
+    if ((h.version != 1 && h.version != kScenarioVersion) || h.recordSize != sizeof(SourceConfig)) {
+        throw std::runtime_error("Not a version " + std::to_string(kScenarioVersion) + " compiled scenario: " + filename);
+    }
+    size_t available = (file.size() - sizeof(ScenarioHeader)) / sizeof(SourceConfig);
+    if (h.sourceCount > INT_MAX || h.sourceCount > available) {
+        throw std::runtime_error(filename + ": header declares " + std::to_string(h.sourceCount) +
+                                 " sources but the file holds " + std::to_string(available));
+    }
+
+    Config config;
+    config.numSources = static_cast<int>(h.sourceCount);
+    config.simulationTime = h.simulationTime;
+    config.linkCapacity = h.linkCapacity;
+    config.bufferSize = static_cast<size_t>(h.bufferSize);
+    config.bufferBytes = static_cast<size_t>(h.bufferBytes);
+    if (const char* problem = linkProblem(config)) throw std::runtime_error(filename + ": " + problem);
+
+    config.sources.resize(config.numSources);
+    if (config.numSources > 0) {
+        std::memcpy(&config.sources[0], file.data() + sizeof(ScenarioHeader),
+                    config.sources.size() * sizeof(SourceConfig));
+    }
+
+    if (h.version >= 2) {
+        size_t offset = sizeof(ScenarioHeader) + config.sources.size() * sizeof(SourceConfig);
+        auto take = [&](void* to, uint64_t count, size_t size) {
+            if (count > (file.size() - offset) / size) throw std::runtime_error("Truncated traffic section in " + filename);
+            if (count > 0) std::memcpy(to, file.data() + offset, count * size);
+            offset += count * size;
+        };
+        uint64_t models = 0, tables = 0;
+        take(&models, 1, sizeof(models));
+        if (models != 0 && models != config.sources.size()) {
+            throw std::runtime_error(filename + ": traffic section does not match the sources");
+        }
+        config.traffic.resize(models);
+        take(config.traffic.data(), models, sizeof(TrafficModel));
+        take(&tables, 1, sizeof(tables));
+        if (tables > (file.size() - offset) / sizeof(uint64_t)) throw std::runtime_error("Truncated traffic section in " + filename);
+        config.sizeTables.resize(tables);
+        for (auto& table : config.sizeTables) {
+            uint64_t entries = 0;
+            take(&entries, 1, sizeof(entries));
+            if (entries == 0 || entries > (file.size() - offset) / sizeof(int32_t)) {
+                throw std::runtime_error("Truncated traffic section in " + filename);
+            }
+            table.sizes.resize(entries);
+            table.weights.resize(entries);
+            take(table.sizes.data(), entries, sizeof(int32_t));
+            take(table.weights.data(), entries, sizeof(double));
+        }
+    }
+
+    for (size_t i = 0; i < config.sources.size(); ++i) {
+        const char* problem = sourceProblem(config.sources[i]);
+        if (!problem) problem = trafficProblem(config, i);
+        if (problem) throw std::runtime_error(filename + ": source " + std::to_string(i) + ": " + problem);
+    }
+    return config;
+}
+
+/**
+ * @brief Loads a scenario file, telling the compiled form from text by its magic.
+ */
+inline Config loadConfig(const std::string& filename) {
+    MappedFile file(filename);
+    if (file.size() >= sizeof(kScenarioMagic) && std::memcmp(file.data(), kScenarioMagic, sizeof(kScenarioMagic)) == 0) {
+        return parseBinaryConfig(file, filename);
+    }
+    return parseTextConfig(file, filename);
+}
+
+/**
+ * @brief Writes `config` as a compiled scenario that loadConfig maps back in.
+ */
+inline void saveBinaryConfig(const Config& config, const std::string& filename) {
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) throw std::runtime_error("Could not open scenario output: " + filename);
+
+    ScenarioHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, kScenarioMagic, sizeof(h.magic));
+    h.version = kScenarioVersion;
+    h.recordSize = sizeof(SourceConfig);
+    h.sourceCount = config.sources.size();
+    h.simulationTime = config.simulationTime;
+    h.linkCapacity = config.linkCapacity;
+    h.bufferSize = config.bufferSize;
+    h.bufferBytes = config.bufferBytes;
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    if (!config.sources.empty()) {
+        out.write(reinterpret_cast<const char*>(&config.sources[0]), config.sources.size() * sizeof(SourceConfig));
+    }
+
+    auto put = [&](const void* from, size_t bytes) { out.write(static_cast<const char*>(from), bytes); };
+    uint64_t models = config.traffic.size();
+    uint64_t tables = config.sizeTables.size();
+    put(&models, sizeof(models));
+    if (models > 0) put(config.traffic.data(), models * sizeof(TrafficModel));
+    put(&tables, sizeof(tables));
+    for (const auto& table : config.sizeTables) {
+        uint64_t entries = table.sizes.size();
+        put(&entries, sizeof(entries));
+        put(table.sizes.data(), entries * sizeof(int32_t));
+        put(table.weights.data(), entries * sizeof(double));
+    }
+    if (!out) throw std::runtime_error("Could not write scenario output: " + filename);
+}
+
+/**
+ * @brief Most packets the buffer can hold under both limits, assuming packets
+ * no smaller than the configured minimum sizes.
+ */
+inline size_t bufferedPacketBound(const Config& config) {
+    size_t bound = config.bufferSize;
+    if (config.bufferBytes > 0 && !config.sources.empty()) {
+        int smallest = INT_MAX;
+        for (const auto& sc : config.sources) smallest = std::min(smallest, std::max(1, sc.minSize));
+        bound = std::min(bound, config.bufferBytes / static_cast<size_t>(smallest));
+    }
+    return bound;
+}
+
+/// @brief Byte limit as a double, +infinity when only packets are counted.
+inline double bufferByteLimit(const Config& config) {
+    return config.bufferBytes > 0 ? static_cast<double>(config.bufferBytes) : HUGE_VAL;
+}
+
+#endif // SIM_CONFIG_H
@@ -0,0 +1,153 @@
+/**
+ * @file drr.h
+ * @brief Deficit Round Robin (DRR) scheduling discipline (Shreedhar & Varghese, 1995).
+ * Each source has its own FIFO and a deficit counter. Backlogged sources sit
+ * on a round-robin active list; on its turn a source is credited its quantum
+ * and sends head packets while they fit in the deficit. Quanta are
+ * proportional to the weights and at least the largest packet size, so every
+ * turn sends a packet and both enqueue and dequeue are O(1).
+ * Drop Policy: Tail-drop on the shared buffer, by packet count and bytes.
+ */
+
+#ifndef SIM_DRR_H
+#define SIM_DRR_H
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+#include "simulator.h"
+
+/// @brief Per-source FIFOs served round-robin with deficit counters.
+class DRRDiscipline {
+private:
+    size_t bufferSize = 0;
+    size_t count = 0;
+    double byteLimit = 0.0;
+    double bytes = 0.0;
+    PacketPool* pool = nullptr;
+
+    std::vector<PacketFifo> flows;
+    std::vector<double> quantum; // Bytes credited per turn
+    std::vector<double> deficit;
+
+    // Active list: ring of backlogged source IDs, the front one being served
+    std::vector<uint32_t> active;
+    size_t activeHead = 0;
+    size_t activeCount = 0;
+    bool frontCredited = false; // Front source already got this turn's quantum
+
+    void activate(uint32_t src) {
+        size_t slot = activeHead + activeCount;
+        if (slot >= active.size()) slot -= active.size();
+        active[slot] = src;
+        ++activeCount;
+    }
+
+    uint32_t popActive() {
+        uint32_t src = active[activeHead];
+        if (++activeHead == active.size()) activeHead = 0;
+        --activeCount;
+        frontCredited = false;
+        return src;
+    }
+
+public:
+    static const char* name() { return "DRR"; }
+    static const bool weightedFairness = true;
+
+    void configure(const Config& config, PacketPool& packetPool) {
+        pool = &packetPool;
+        bufferSize = config.bufferSize;
+        count = 0;
+        byteLimit = bufferByteLimit(config);
+        bytes = 0.0;
+
+        size_t n = config.sources.size();
+        double minWeight = 0.0;
+        int maxSize = 1;
+        for (const auto& sc : config.sources) {
+            if (sc.weight > 0 && (minWeight == 0.0 || sc.weight < minWeight)) minWeight = sc.weight;
+            maxSize = std::max(maxSize, sc.maxSize);
+        }
+        // The lightest source gets one maximum-size packet per turn; sources
+        // without a positive weight are treated as the lightest
+        quantum.assign(n, maxSize);
+        for (size_t i = 0; i < n; ++i) {
+            double w = config.sources[i].weight;
+            if (w > 0 && minWeight > 0) quantum[i] = maxSize * (w / minWeight);
+        }
+        deficit.assign(n, 0.0);
+        flows.assign(n, PacketFifo());
+        active.assign(n, 0);
+        activeHead = activeCount = 0;
+        frontCredited = false;
+    }
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+
+    template <class OnDrop>
+    void enqueue(PacketHandle h, OnDrop onDrop) {
+        const Packet& p = (*pool)[h];
+        if (count >= bufferSize || bytes + p.size > byteLimit) {
+            onDrop(h);
+            return;
+        }
+        uint32_t src = static_cast<uint32_t>(p.sourceID);
+        if (flows[src].pushBack(*pool, h)) activate(src);
+        ++count;
+        bytes += p.size;
+    }
+
+    PacketHandle dequeue() {
+        for (;;) {
+            uint32_t src = active[activeHead];
+            if (!frontCredited) {
+                deficit[src] += quantum[src];
+                frontCredited = true;
+            }
+
+            PacketFifo& flow = flows[src];
+            double size = (*pool)[flow.head].size;
+            if (size <= deficit[src]) {
+                deficit[src] -= size;
+                PacketHandle h = flow.popFront(*pool);
+                --count;
+                bytes -= size;
+                if (flow.empty()) {
+                    // An idle source keeps no credit into its next backlog
+                    deficit[src] = 0.0;
+                    popActive();
+                }
+                return h;
+            }
+
+            // Turn over: the source keeps its deficit and goes to the back
+            activate(popActive());
+        }
+    }
+
+    void saveState(StateWriter& out) const {
+        out.put(count, bytes, activeHead, activeCount, frontCredited);
+        out.putVector(flows);
+        out.putVector(deficit);
+        out.putVector(active);
+    }
+
+    void loadState(StateReader& in) {
+        size_t n = flows.size();
+        in.get(count, bytes, activeHead, activeCount, frontCredited);
+        in.getVector(flows, n);
+        in.getVector(deficit, n);
+        in.getVector(active, n);
+        if (activeCount > n || (n > 0 && activeHead >= n)) {
+            throw std::runtime_error("Checkpoint does not match the configured scenario");
+        }
+    }
+};
+
+typedef Simulator<DRRDiscipline> DRRSimulator;
+
+#endif // SIM_DRR_H
@@ -0,0 +1,462 @@
+/**
+ * @file event_queue.h
+ * @brief Future-event-list implementations for the simulation engine.
+ * Every backend stores Events ordered by time and exposes the same interface,
+ * so the engine can take the queue type as a template parameter:
+ *   void push(const Event&);
+ *   Event pop();          // Removes and returns the earliest event
+ *   bool empty() const;
+ *   size_t size() const;
+ *   void clear();
+ *   void saveState(StateWriter&) const; // Exact internal layout, for checkpoints
+ *   void loadState(StateReader&);
+ */
+
+#ifndef SIM_EVENT_QUEUE_H
+#define SIM_EVENT_QUEUE_H
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+
+#include "checkpoint.h"
+
+/**
+ * @brief Represents a discrete simulation event (Arrival or Departure).
+ * Kept at 16 bytes so heap sifts move as little memory as possible: the
+ * index is the ArrivalStream for arrivals, a PacketPool handle for departures
+ * and hop arrivals (a packet handed on by an upstream link, see topology.h)
+ * and the sample number for metrics samples and run-control checks (0 is
+ * the fixed warm-up cutoff); replay arrivals do not use it. In flow mode
+ * (flows.h) flow arrivals carry the flow class and packet arrivals the flow ID.
+ */
+struct Event {
+    enum Type : uint32_t { PACKET_ARRIVAL, PACKET_DEPARTURE, REPLAY_ARRIVAL, METRICS_SAMPLE, HOP_ARRIVAL, RUN_CONTROL, FLOW_ARRIVAL };
+
+    double time;
+    Type type;
+    uint32_t index;
+
+    Event() = default;
+    Event(Type t, double tm, uint32_t idx) : time(tm), type(t), index(idx) {}
+
+    // Min-heap comparator (earliest time first)
+    bool operator>(const Event& other) const {
+        return time > other.time;
+    }
+};
+
+static_assert(sizeof(Event) == 16, "Event should stay compact");
+
+/// @brief Binary heap via std::push_heap/pop_heap (the std::priority_queue
+/// algorithm), O(log n) push and pop. clear() keeps the allocation.
+class BinaryHeapQueue {
+private:
+    std::vector<Event> heap;
+
+public:
+    static const char* name() { return "binary"; }
+
+    void push(const Event& e) {
+        heap.push_back(e);
+        std::push_heap(heap.begin(), heap.end(), std::greater<Event>());
+    }
+
+    Event pop() {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<Event>());
+        Event e = heap.back();
+        heap.pop_back();
+        return e;
+    }
+
+    bool empty() const { return heap.empty(); }
+    size_t size() const { return heap.size(); }
+    void clear() { heap.clear(); }
+
+    void saveState(StateWriter& out) const { out.putVector(heap); }
+    void loadState(StateReader& in) { in.getVector(heap); }
+};
+
+/// @brief Implicit 4-ary min-heap: half the depth of a binary heap and
+/// children of a node share a cache line.
+class QuaternaryHeapQueue {
+private:
+    std::vector<Event> heap;
+
+public:
+    static const char* name() { return "dary"; }
+
+    void push(const Event& e) {
+        size_t hole = heap.size();
+        heap.push_back(e);
+        while (hole > 0) {
+            size_t parent = (hole - 1) / 4;
+            if (!(heap[parent].time > e.time)) break;
+            heap[hole] = heap[parent];
+            hole = parent;
+        }
+        heap[hole] = e;
+    }
+
+    Event pop() {
+        Event top = heap.front();
+        Event last = heap.back();
+        heap.pop_back();
+
+        size_t n = heap.size();
+        if (n > 0) {
+            // Sift the former last element down from the root
+            size_t hole = 0;
+            for (;;) {
+                size_t first = 4 * hole + 1;
+                if (first >= n) break;
+                size_t end = std::min(first + 4, n);
+                size_t best = first;
+                for (size_t c = first + 1; c < end; ++c) {
+                    if (heap[c].time < heap[best].time) best = c;
+                }
+                if (!(heap[best].time < last.time)) break;
+                heap[hole] = heap[best];
+                hole = best;
+            }
+            heap[hole] = last;
+        }
+        return top;
+    }
+
+    bool empty() const { return heap.empty(); }
+    size_t size() const { return heap.size(); }
+    void clear() { heap.clear(); }
+
+    void saveState(StateWriter& out) const { out.putVector(heap); }
+    void loadState(StateReader& in) { in.getVector(heap); }
+};
+
+/**
+ * @brief Brown's calendar queue, O(1) amortized push and pop.
+ * Events hash into "day" buckets of a fixed width; a dequeue scans forward
+ * from the current day. The bucket count doubles/halves with the population
+ * and the width is re-estimated from the spacing of the earliest events.
+ */
+class CalendarQueue {
+private:
+    // Each bucket is sorted by descending time so the minimum sits at back()
+    std::vector<std::vector<Event>> buckets;
+    size_t mask = 0;
+    double width = 1.0;
+    size_t count = 0;
+    uint64_t currentSlot = 0; // Absolute day number being served
+    double lastTime = 0.0;
+    std::vector<Event> scratch;
+
+    uint64_t slotOf(double t) const {
+        return static_cast<uint64_t>(t / width);
+    }
+
+    static void insertSorted(std::vector<Event>& bucket, const Event& e) {
+        // Equal times go in front of existing ones so they leave in FIFO order
+        auto pos = std::lower_bound(bucket.begin(), bucket.end(), e,
+                                    [](const Event& a, const Event& b) { return a.time > b.time; });
+        bucket.insert(pos, e);
+    }
+
+    void resize(size_t newBuckets) {
+        scratch.clear();
+        for (auto& b : buckets) {
+            scratch.insert(scratch.end(), b.begin(), b.end());
+            b.clear();
+        }
+
+        // New width: three times the mean gap between the earliest events,
+        // ignoring gaps more than twice the mean (Brown, 1988)
+        size_t sample = std::min<size_t>(scratch.size(), 25);
+        if (sample >= 2) {
+            std::partial_sort(scratch.begin(), scratch.begin() + sample, scratch.end(),
+                              [](const Event& a, const Event& b) { return a.time < b.time; });
+            double span = scratch[sample - 1].time - scratch[0].time;
+            double mean = span / (sample - 1);
+            double sum = 0.0;
+            size_t used = 0;
+            for (size_t i = 1; i < sample; ++i) {
+                double gap = scratch[i].time - scratch[i - 1].time;
+                if (gap <= 2.0 * mean) {
+                    sum += gap;
+                    ++used;
+                }
+            }
+            double refined = used > 0 ? sum / used : mean;
+            if (refined > 0.0) width = 3.0 * refined;
+        }
+
+        buckets.resize(newBuckets);
+        mask = newBuckets - 1;
+        currentSlot = slotOf(lastTime);
+        for (const Event& e : scratch) insertSorted(buckets[slotOf(e.time) & mask], e);
+    }
+
+public:
+    static const char* name() { return "calendar"; }
+
+    CalendarQueue() { clear(); }
+
+    void push(const Event& e) {
+        uint64_t slot = slotOf(e.time);
+        if (slot < currentSlot) currentSlot = slot;
+        insertSorted(buckets[slot & mask], e);
+        if (++count > 2 * buckets.size()) resize(2 * buckets.size());
+    }
+
+    Event pop() {
+        size_t nBuckets = buckets.size();
+        size_t found = nBuckets;
+
+        for (size_t scanned = 0; scanned < nBuckets; ++scanned, ++currentSlot) {
+            const std::vector<Event>& b = buckets[currentSlot & mask];
+            if (!b.empty() && slotOf(b.back().time) <= currentSlot) {
+                found = currentSlot & mask;
+                break;
+            }
+        }
+
+        if (found == nBuckets) {
+            // A whole year is empty: jump straight to the global minimum
+            double best = std::numeric_limits<double>::infinity();
+            for (size_t i = 0; i < nBuckets; ++i) {
+                if (!buckets[i].empty() && buckets[i].back().time < best) {
+                    best = buckets[i].back().time;
+                    found = i;
+                }
+            }
+            currentSlot = slotOf(best);
+        }
+
+        Event e = buckets[found].back();
+        buckets[found].pop_back();
+        lastTime = e.time;
+        if (--count < nBuckets / 2 && nBuckets > 2) resize(nBuckets / 2);
+        return e;
+    }
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+
+    void clear() {
+        buckets.assign(2, std::vector<Event>());
+        mask = 1;
+        width = 1.0;
+        count = 0;
+        currentSlot = 0;
+        lastTime = 0.0;
+    }
+
+    void saveState(StateWriter& out) const {
+        out.put(width, count, currentSlot, lastTime, static_cast<uint64_t>(buckets.size()));
+        for (const auto& b : buckets) out.putVector(b);
+    }
+
+    void loadState(StateReader& in) {
+        uint64_t n = 0;
+        in.get(width, count, currentSlot, lastTime, n);
+        if (n == 0 || (n & (n - 1)) != 0 || n > in.remaining() / sizeof(uint64_t)) throw std::runtime_error("Corrupt calendar queue in checkpoint");
+        buckets.resize(static_cast<size_t>(n));
+        for (auto& b : buckets) in.getVector(b);
+        mask = buckets.size() - 1;
+    }
+};
+
+/**
+ * @brief Ladder queue (Tang, Goh & Thng, 2005), O(1) amortized push and pop.
+ * Far-future events are appended unsorted to Top. When the near future runs
+ * dry, Top is spread over a rung of buckets; oversized buckets spawn finer
+ * rungs and small ones are sorted into Bottom, which serves dequeues.
+ */
+class LadderQueue {
+private:
+    static const size_t kThreshold = 50; // Max bucket size sorted directly into Bottom
+    static const size_t kMaxRungs = 8;
+
+    struct Rung {
+        double start = 0.0;
+        double width = 0.0;
+        size_t current = 0; // First bucket not yet handed down
+        std::vector<std::vector<Event>> buckets;
+
+        double currentStart() const { return start + current * width; }
+    };
+
+    std::vector<Event> top;
+    double topMin = 0.0;
+    double topMax = 0.0;
+    double topStart = -std::numeric_limits<double>::infinity();
+
+    std::vector<Rung> rungs; // Storage is reused; only the first numRungs are live
+    size_t numRungs = 0;
+
+    std::vector<Event> bottom; // Sorted by descending time, minimum at back()
+    std::vector<Event> spill;  // Scratch space while splitting a bucket
+    size_t count = 0;
+
+    static bool later(const Event& a, const Event& b) { return a.time > b.time; }
+
+    void sortIntoBottom(std::vector<Event>& events) {
+        // Stable so equal-time events keep their insertion order (reversed below)
+        std::stable_sort(events.begin(), events.end(),
+                         [](const Event& a, const Event& b) { return a.time < b.time; });
+        bottom.assign(events.rbegin(), events.rend());
+        events.clear();
+    }
+
+    Rung& spawnRung(double start, double width, size_t nBuckets) {
+        if (rungs.size() <= numRungs) rungs.resize(numRungs + 1);
+        Rung& r = rungs[numRungs++];
+        r.start = start;
+        r.width = width;
+        r.current = 0;
+        if (r.buckets.size() < nBuckets) r.buckets.resize(nBuckets);
+        for (size_t i = 0; i < nBuckets; ++i) r.buckets[i].clear();
+        r.buckets.resize(nBuckets);
+        return r;
+    }
+
+    static void insertIntoRung(Rung& r, const Event& e) {
+        size_t n = r.buckets.size();
+        double offset = (e.time - r.start) / r.width;
+        size_t b = 0;
+        if (offset >= static_cast<double>(n)) b = n - 1;
+        else if (offset > 0.0) b = static_cast<size_t>(offset);
+        if (b < r.current) b = r.current; // Rounding at the current bucket edge
+        r.buckets[b].push_back(e);
+    }
+
+    // Moves the next batch of earliest events into Bottom. Requires count > 0.
+    void refillBottom() {
+        for (;;) {
+            if (numRungs == 0) {
+                if (top.size() <= kThreshold || topMax == topMin) {
+                    topStart = topMax;
+                    sortIntoBottom(top);
+                    return;
+                }
+                size_t n = top.size();
+                double w = (topMax - topMin) / n;
+                Rung& r = spawnRung(topMin, w, n + 1);
+                topStart = topMin + (n + 1) * w;
+                for (const Event& e : top) insertIntoRung(r, e);
+                top.clear();
+            }
+
+            Rung& r = rungs[numRungs - 1];
+            size_t n = r.buckets.size();
+            while (r.current < n && r.buckets[r.current].empty()) ++r.current;
+            if (r.current == n) {
+                --numRungs;
+                continue;
+            }
+
+            std::vector<Event>& bucket = r.buckets[r.current];
+            double bucketStart = r.currentStart();
+            double bucketWidth = r.width;
+            ++r.current;
+
+            if (bucket.size() > kThreshold && numRungs < kMaxRungs) {
+                // Spread the crowded bucket over a finer rung. An exhausted
+                // parent is retired first so the child can reuse its slot.
+                size_t m = bucket.size();
+                spill.swap(bucket);
+                if (r.current == n) --numRungs;
+                Rung& child = spawnRung(bucketStart, bucketWidth / m, m);
+                for (const Event& e : spill) insertIntoRung(child, e);
+                spill.clear();
+                continue;
+            }
+
+            if (r.current == n) --numRungs;
+            sortIntoBottom(bucket);
+            return;
+        }
+    }
+
+public:
+    static const char* name() { return "ladder"; }
+
+    void push(const Event& e) {
+        ++count;
+        if (e.time >= topStart) {
+            if (top.empty()) {
+                topMin = topMax = e.time;
+            } else {
+                topMin = std::min(topMin, e.time);
+                topMax = std::max(topMax, e.time);
+            }
+            top.push_back(e);
+            return;
+        }
+
+        for (size_t i = 0; i < numRungs; ++i) {
+            if (e.time >= rungs[i].currentStart()) {
+                insertIntoRung(rungs[i], e);
+                return;
+            }
+        }
+
+        // Earlier than every rung: goes straight into the sorted Bottom
+        auto pos = std::lower_bound(bottom.begin(), bottom.end(), e, later);
+        bottom.insert(pos, e);
+    }
+
+    Event pop() {
+        if (bottom.empty()) refillBottom();
+        Event e = bottom.back();
+        bottom.pop_back();
+        --count;
+        return e;
+    }
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+
+    void clear() {
+        top.clear();
+        topStart = -std::numeric_limits<double>::infinity();
+        numRungs = 0;
+        bottom.clear();
+        count = 0;
+    }
+
+    void saveState(StateWriter& out) const {
+        out.putVector(top);
+        out.put(topMin, topMax, topStart, static_cast<uint64_t>(numRungs));
+        for (size_t i = 0; i < numRungs; ++i) {
+            const Rung& r = rungs[i];
+            out.put(r.start, r.width, static_cast<uint64_t>(r.current), static_cast<uint64_t>(r.buckets.size()));
+            for (const auto& b : r.buckets) out.putVector(b);
+        }
+        out.putVector(bottom);
+        out.put(count);
+    }
+
+    void loadState(StateReader& in) {
+        in.getVector(top);
+        uint64_t n = 0;
+        in.get(topMin, topMax, topStart, n);
+        if (n > kMaxRungs) throw std::runtime_error("Corrupt ladder queue in checkpoint");
+        numRungs = static_cast<size_t>(n);
+        if (rungs.size() < numRungs) rungs.resize(numRungs);
+        for (size_t i = 0; i < numRungs; ++i) {
+            Rung& r = rungs[i];
+            uint64_t current = 0, nBuckets = 0;
+            in.get(r.start, r.width, current, nBuckets);
+            if (nBuckets > in.remaining() / sizeof(uint64_t)) throw std::runtime_error("Corrupt ladder queue in checkpoint");
+            r.current = static_cast<size_t>(current);
+            r.buckets.resize(static_cast<size_t>(nBuckets));
+            for (auto& b : r.buckets) in.getVector(b);
+        }
+        in.getVector(bottom);
+        in.get(count);
+    }
+};
+
+#endif // SIM_EVENT_QUEUE_H
@@ -0,0 +1,293 @@
+/**
+ * @file export.h
+ * @brief Structured result export through a background writer thread.
+ * The printResults reports are fixed-width text for people to read. For
+ * tooling, results are also emitted as rows: a table name ("system",
+ * "source", "summary", ...) and named numeric fields. Producers, which may
+ * be replication or sweep workers, push rows into a bounded queue and go
+ * back to simulating; one writer thread formats and writes them, so runs
+ * stream out as they finish rather than when the whole batch is done.
+ *
+ * JSON output is JSON Lines, one object per row with its table under
+ * "table". CSV output is one file per table, named by inserting the table
+ * before the extension (results.csv -> results_source.csv), with the header
+ * taken from the table's first row. Non-finite values are written as null
+ * in JSON and left empty in CSV.
+ */
+
+#ifndef SIM_EXPORT_H
+#define SIM_EXPORT_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <utility>
+#include <fstream>
+#include <iomanip>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <stdexcept>
+#include <cmath>
+
+#include "simulator.h"
+#include "replications.h"
+
+enum class ExportFormat { JSON, CSV };
+
+/// @brief Parses --export: json or csv.
+inline ExportFormat parseExportFormat(const std::string& name) {
+    if (name == "json") return ExportFormat::JSON;
+    if (name == "csv") return ExportFormat::CSV;
+    throw std::invalid_argument("--export must be json or csv: " + name);
+}
+
+/// @brief File extension of a format, without the dot.
+inline const char* exportExtension(ExportFormat format) {
+    return format == ExportFormat::JSON ? "jsonl" : "csv";
+}
+
+/// @brief One exported row: its table and its fields in column order.
+struct ExportRow {
+    std::string table;
+    std::vector<std::pair<std::string, double>> fields;
+
+    ExportRow() = default;
+    explicit ExportRow(const std::string& name) : table(name) {}
+
+    ExportRow& add(const std::string& name, double value) {
+        fields.emplace_back(name, value);
+        return *this;
+    }
+};
+
+/**
+ * @brief Bounded multi-producer queue of rows drained by one writer thread.
+ * push() blocks only while kQueueRows rows are waiting. A write error stops
+ * the output, and close() rethrows it on the calling thread.
+ */
+class ResultExporter {
+private:
+    static const size_t kQueueRows = 4096;
+
+    struct CsvTable {
+        std::ofstream file;
+        std::vector<std::string> columns;
+    };
+
+    ExportFormat format = ExportFormat::JSON;
+    std::string path;
+    std::ofstream json;
+    std::map<std::string, std::unique_ptr<CsvTable>> csvTables; // Writer thread only
+
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::condition_variable space;
+    std::deque<ExportRow> pending;
+    bool closing = false;
+    bool failed = false;
+    std::exception_ptr error;
+    std::thread writer;
+
+    static void putNumber(std::ostream& out, double v, const char* missing) {
+        if (std::isfinite(v)) {
+            out << v;
+        } else {
+            out << missing;
+        }
+    }
+
+    // Table and field names are identifiers chosen by the callers, so they
+    // need no JSON escaping
+    void writeJson(const ExportRow& row) {
+        json << "{\"table\": \"" << row.table << "\"";
+        for (const auto& f : row.fields) {
+            json << ", \"" << f.first << "\": ";
+            putNumber(json, f.second, "null");
+        }
+        json << "}\n";
+    }
+
+    void writeCsv(const ExportRow& row) {
+        std::unique_ptr<CsvTable>& table = csvTables[row.table];
+        if (!table) {
+            table.reset(new CsvTable);
+            std::string name = tablePath(row.table);
+            table->file.open(name);
+            if (!table->file) throw std::runtime_error("Could not create export file: " + name);
+            table->file << std::setprecision(17);
+            for (size_t i = 0; i < row.fields.size(); ++i) {
+                table->columns.push_back(row.fields[i].first);
+                table->file << (i ? "," : "") << row.fields[i].first;
+            }
+            table->file << "\n";
+        }
+        bool matches = row.fields.size() == table->columns.size();
+        for (size_t i = 0; matches && i < row.fields.size(); ++i) matches = row.fields[i].first == table->columns[i];
+        if (!matches) throw std::logic_error("Rows of export table " + row.table + " differ in their columns");
+        for (size_t i = 0; i < row.fields.size(); ++i) {
+            if (i) table->file << ",";
+            putNumber(table->file, row.fields[i].second, "");
+        }
+        table->file << "\n";
+        if (!table->file) throw std::runtime_error("Could not write export file: " + tablePath(row.table));
+    }
+
+    void drain() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            ready.wait(lock, [this] { return closing || !pending.empty(); });
+            if (pending.empty()) break;
+            ExportRow row = std::move(pending.front());
+            pending.pop_front();
+            space.notify_one();
+            if (failed) continue;
+            lock.unlock();
+            try {
+                if (format == ExportFormat::JSON) {
+                    writeJson(row);
+                    if (!json) throw std::runtime_error("Could not write export file: " + path);
+                } else {
+                    writeCsv(row);
+                }
+            } catch (...) {
+                lock.lock();
+                failed = true;
+                error = std::current_exception();
+                continue;
+            }
+            lock.lock();
+        }
+    }
+
+public:
+    ResultExporter() = default;
+    ResultExporter(const ResultExporter&) = delete;
+    ResultExporter& operator=(const ResultExporter&) = delete;
+
+    ~ResultExporter() {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+
+    /**
+     * @brief Starts the writer. For JSON `filename` is the output file; for
+     * CSV it names the per-table files.
+     */
+    void open(const std::string& filename, ExportFormat exportFormat) {
+        format = exportFormat;
+        path = filename;
+        if (format == ExportFormat::JSON) {
+            json.open(path);
+            if (!json) throw std::runtime_error("Could not create export file: " + path);
+            json << std::setprecision(17);
+        }
+        closing = failed = false;
+        writer = std::thread([this] { drain(); });
+    }
+
+    bool enabled() const { return writer.joinable(); }
+    const std::string& filename() const { return path; }
+
+    /// @brief Path of the CSV file holding `table`.
+    std::string tablePath(const std::string& table) const {
+        size_t dot = path.find_last_of('.');
+        size_t slash = path.find_last_of('/');
+        if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return path + "_" + table;
+        return path.substr(0, dot) + "_" + table + path.substr(dot);
+    }
+
+    /// @brief Queues a row; safe to call from any thread while the exporter is open.
+    void push(ExportRow row) {
+        std::unique_lock<std::mutex> lock(mutex);
+        space.wait(lock, [this] { return pending.size() < kQueueRows; });
+        pending.push_back(std::move(row));
+        ready.notify_one();
+    }
+
+    /// @brief Writes every queued row, stops the writer and rethrows its error, if any.
+    void close() {
+        if (!writer.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closing = true;
+        }
+        ready.notify_one();
+        writer.join();
+        json.close();
+        csvTables.clear();
+        if (error) {
+            std::exception_ptr e = error;
+            error = nullptr;
+            std::rethrow_exception(e);
+        }
+    }
+};
+
+/// @brief Leading key columns of a row, such as the replication or grid point.
+typedef std::vector<std::pair<std::string, double>> ExportKeys;
+
+/**
+ * @brief Queues the "system" row and one "source" row per source of a run,
+ * each led by `keys`.
+ */
+inline void exportMetrics(ResultExporter& out, const Metrics& m, const ExportKeys& keys) {
+    ExportRow system("system");
+    system.fields = keys;
+    system.add("utilization", m.utilization)
+        .add("avg_delay", m.avgDelay)
+        .add("drop_probability", m.dropProbability)
+        .add("fairness", m.fairness)
+        .add("delay_p50", m.delayP50)
+        .add("delay_p99", m.delayP99)
+        .add("delay_p999", m.delayP999)
+        .add("measure_start", m.measureStart)
+        .add("measure_end", m.measureEnd);
+    out.push(std::move(system));
+
+    for (size_t i = 0; i < m.sources.size(); ++i) {
+        const SourceMetrics& sm = m.sources[i];
+        ExportRow row("source");
+        row.fields = keys;
+        row.add("source", static_cast<double>(i))
+            .add("weight", sm.weight)
+            .add("packets_generated", static_cast<double>(sm.packetsGenerated))
+            .add("packets_transmitted", static_cast<double>(sm.packetsTransmitted))
+            .add("packets_dropped", static_cast<double>(sm.packetsDropped))
+            .add("drop_rate", sm.dropRate)
+            .add("avg_delay", sm.avgDelay)
+            .add("delay_p50", sm.delayP50)
+            .add("delay_p99", sm.delayP99)
+            .add("delay_p999", sm.delayP999)
+            .add("throughput", sm.throughput);
+        out.push(std::move(row));
+    }
+}
+
+/**
+ * @brief Queues the "summary" row of a set of replications, every metric as
+ * a mean and its 95% CI half-width, led by `keys`.
+ */
+inline void exportSummary(ResultExporter& out, const ReplicationSummary& s, const ExportKeys& keys) {
+    ExportRow row("summary");
+    row.fields = keys;
+    row.add("replications", static_cast<double>(s.replications));
+    auto add = [&row](const char* name, const Estimate& e) {
+        row.add(name, e.mean).add(std::string(name) + "_ci", e.halfWidth);
+    };
+    add("utilization", s.utilization);
+    add("avg_delay", s.avgDelay);
+    add("drop_probability", s.dropProbability);
+    add("fairness", s.fairness);
+    add("delay_p50", s.delayP50);
+    add("delay_p99", s.delayP99);
+    add("delay_p999", s.delayP999);
+    out.push(std::move(row));
+}
+
+#endif // SIM_EXPORT_H
@@ -0,0 +1,95 @@
+/**
+ * @file fcfs.h
+ * @brief First-Come-First-Serve (FCFS) scheduling discipline.
+ * FIFO service order with a tail-drop buffer: an arriving packet is dropped
+ * when the buffer already holds bufferSize packets, or when its bytes would
+ * push the running byte total past bufferBytes.
+ */
+
+#ifndef SIM_FCFS_H
+#define SIM_FCFS_H
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include "simulator.h"
+
+/// @brief FIFO ring of packet handles with tail-drop admission.
+class FCFSDiscipline {
+private:
+    size_t bufferSize = 0;
+    double byteLimit = 0.0;
+    double bytes = 0.0;             // Bytes currently buffered
+    std::vector<PacketHandle> ring; // Sized for bufferedPacketBound(), grown up to bufferSize
+    size_t head = 0;
+    size_t count = 0;
+    PacketPool* pool = nullptr;
+
+    // Only reached when packets smaller than the configured sizes (replay)
+    // fit more of them in the byte limit than the bound assumed
+    void grow() {
+        std::vector<PacketHandle> wider(std::min(bufferSize, 2 * ring.size() + 1));
+        for (size_t i = 0; i < count; ++i) wider[i] = ring[(head + i) % ring.size()];
+        ring.swap(wider);
+        head = 0;
+    }
+
+public:
+    static const char* name() { return "FCFS"; }
+    static const bool weightedFairness = false;
+
+    void configure(const Config& config, PacketPool& packetPool) {
+        pool = &packetPool;
+        bufferSize = config.bufferSize;
+        byteLimit = bufferByteLimit(config);
+        bytes = 0.0;
+        ring.resize(bufferedPacketBound(config));
+        head = 0;
+        count = 0;
+    }
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+
+    template <class OnDrop>
+    void enqueue(PacketHandle h, OnDrop onDrop) {
+        // Buffer or drop (tail-drop)
+        int size = (*pool)[h].size;
+        if (count < bufferSize && bytes + size <= byteLimit) {
+            if (count == ring.size()) grow();
+            size_t tail = head + count;
+            if (tail >= ring.size()) tail -= ring.size();
+            ring[tail] = h;
+            ++count;
+            bytes += size;
+        } else {
+            onDrop(h);
+        }
+    }
+
+    PacketHandle dequeue() {
+        PacketHandle h = ring[head];
+        if (++head == ring.size()) head = 0;
+        --count;
+        bytes -= (*pool)[h].size;
+        return h;
+    }
+
+    void saveState(StateWriter& out) const {
+        out.put(bytes, head, count);
+        out.putVector(ring);
+    }
+
+    void loadState(StateReader& in) {
+        in.get(bytes, head, count);
+        in.getVector(ring);
+        if (count > ring.size() || (count > 0 && head >= ring.size()) || ring.size() > bufferSize) {
+            throw std::runtime_error("Checkpoint does not match the configured scenario");
+        }
+    }
+};
+
+typedef Simulator<FCFSDiscipline> FCFSSimulator;
+
+#endif // SIM_FCFS_H
@@ -0,0 +1,194 @@
+/**
+ * @file flow_buffer.h
+ * @brief Shared buffer of per-source FIFOs served in tag order.
+ * Fair-queuing tags (e.g. WFQ virtual finish times) are strictly increasing
+ * within a source, so each source's packets can wait in a plain FIFO and only
+ * the head tags need ordering. An IndexedMinHeap over backlogged sources gives
+ * the global minimum, making every operation O(log numSources) no matter how
+ * many packets are buffered. The FIFOs are chained through the PacketPool's
+ * links, so buffering never allocates. A running byte total is kept for
+ * byte-limited buffers.
+ *
+ * Flow mode has far more flows than buffered packets, so TaggedPacketHeap
+ * drops the per-flow FIFOs and keeps the buffered packets themselves in one
+ * binary heap by tag, O(log bufferSize) per operation with no per-flow state.
+ */
+
+#ifndef SIM_FLOW_BUFFER_H
+#define SIM_FLOW_BUFFER_H
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <cstdint>
+
+#include "packet_pool.h"
+#include "indexed_heap.h"
+
+class TaggedFlowBuffer {
+private:
+    PacketPool* pool = nullptr;
+    std::vector<PacketFifo> flows;
+    IndexedMinHeap heads; // Backlogged sources keyed by their head packet's tag
+    size_t count = 0;
+    double bytes = 0.0;
+
+    double tagOf(PacketHandle h) const { return (*pool)[h].virtualFinishTime; }
+
+public:
+    void reset(size_t numSources, PacketPool& packetPool) {
+        pool = &packetPool;
+        flows.assign(numSources, PacketFifo());
+        heads.reset(numSources);
+        count = 0;
+        bytes = 0.0;
+    }
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+    double byteCount() const { return bytes; }
+
+    /// @brief Packet with the smallest tag across all sources.
+    PacketHandle top() const { return flows[heads.top()].head; }
+
+    /// @brief Appends a packet; its tag must not be below its source's last tag.
+    void push(PacketHandle h) {
+        uint32_t src = static_cast<uint32_t>((*pool)[h].sourceID);
+        if (flows[src].pushBack(*pool, h)) heads.push(src, tagOf(h));
+        ++count;
+        bytes += (*pool)[h].size;
+    }
+
+    PacketHandle pop() {
+        uint32_t src = heads.top();
+        PacketFifo& flow = flows[src];
+        PacketHandle h = flow.popFront(*pool);
+        if (flow.empty()) heads.pop();
+        else heads.update(src, tagOf(flow.head));
+        --count;
+        bytes -= (*pool)[h].size;
+        return h;
+    }
+
+    /**
+     * @brief Removes smallest-tag packets, handing each to onEvict, until at
+     * least `needed` bytes are freed or the buffer is empty. Consecutive
+     * victims from one source are taken as a run while its next tag stays
+     * within the other sources' smallest head tag, so each run costs a single
+     * heap adjustment rather than one per packet.
+     */
+    template <class OnEvict>
+    void evictBytes(double needed, OnEvict onEvict) {
+        double target = bytes - needed;
+        while (bytes > target && count > 0) {
+            uint32_t src = heads.top();
+            PacketFifo& flow = flows[src];
+            double bound = heads.secondKey();
+            do {
+                PacketHandle h = flow.popFront(*pool);
+                --count;
+                bytes -= (*pool)[h].size;
+                onEvict(h);
+            } while (bytes > target && !flow.empty() && tagOf(flow.head) <= bound);
+
+            if (flow.empty()) heads.pop();
+            else heads.update(src, tagOf(flow.head));
+        }
+    }
+
+    /**
+     * @brief Removes the smallest-tag packet and inserts h in its place.
+     * Costs one heap sift when the evicted packet was its source's last one
+     * and h starts a new backlog, instead of a separate pop and push.
+     */
+    PacketHandle replaceTop(PacketHandle h) {
+        uint32_t src = heads.top();
+        uint32_t dst = static_cast<uint32_t>((*pool)[h].sourceID);
+        PacketFifo& from = flows[src];
+
+        PacketHandle evicted = from.popFront(*pool);
+        bool startsBacklog = flows[dst].pushBack(*pool, h);
+
+        bytes += (*pool)[h].size - (*pool)[evicted].size;
+        if (src == dst) {
+            heads.update(src, tagOf(from.head));
+        } else if (from.empty() && startsBacklog) {
+            heads.replaceTop(dst, tagOf(h));
+        } else {
+            if (from.empty()) heads.pop();
+            else heads.update(src, tagOf(from.head));
+            if (startsBacklog) heads.push(dst, tagOf(h));
+        }
+        return evicted;
+    }
+
+    void saveState(StateWriter& out) const {
+        out.put(count, bytes);
+        out.putVector(flows);
+        heads.saveState(out);
+    }
+
+    void loadState(StateReader& in) {
+        in.get(count, bytes);
+        in.getVector(flows, flows.size());
+        heads.loadState(in);
+    }
+};
+
+/// @brief Buffered packets in one min-heap by tag, with the TaggedFlowBuffer interface.
+class TaggedPacketHeap {
+private:
+    struct Entry {
+        double tag;
+        PacketHandle handle;
+
+        bool operator>(const Entry& other) const { return tag > other.tag; }
+    };
+
+    PacketPool* pool = nullptr;
+    std::vector<Entry> heap;
+    double bytes = 0.0;
+
+public:
+    void reset(PacketPool& packetPool) {
+        pool = &packetPool;
+        heap.clear();
+        bytes = 0.0;
+    }
+
+    bool empty() const { return heap.empty(); }
+    size_t size() const { return heap.size(); }
+    double byteCount() const { return bytes; }
+
+    PacketHandle top() const { return heap.front().handle; }
+
+    void push(PacketHandle h) {
+        heap.push_back(Entry{(*pool)[h].virtualFinishTime, h});
+        std::push_heap(heap.begin(), heap.end(), std::greater<Entry>());
+        bytes += (*pool)[h].size;
+    }
+
+    PacketHandle pop() {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<Entry>());
+        PacketHandle h = heap.back().handle;
+        heap.pop_back();
+        bytes -= (*pool)[h].size;
+        return h;
+    }
+
+    /// @brief As TaggedFlowBuffer::evictBytes().
+    template <class OnEvict>
+    void evictBytes(double needed, OnEvict onEvict) {
+        double target = bytes - needed;
+        while (bytes > target && !heap.empty()) onEvict(pop());
+    }
+
+    /// @brief Removes the smallest-tag packet and inserts h in its place.
+    PacketHandle replaceTop(PacketHandle h) {
+        PacketHandle evicted = pop();
+        push(h);
+        return evicted;
+    }
+};
+
+#endif // SIM_FLOW_BUFFER_H
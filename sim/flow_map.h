@@ -0,0 +1,131 @@
+/**
+ * @file flow_map.h
+ * @brief Open-addressing hash map from 32-bit flow IDs to small records.
+ * Flow mode tracks only the flows that are currently active, which are few
+ * next to the IDs handed out over a run. Records are stored inline in one
+ * power-of-two array probed linearly from a Fibonacci hash of the ID, so a
+ * lookup is usually a single cache line and the map never allocates per
+ * entry. Deletion shifts the following entries of the probe run back
+ * instead of leaving tombstones, which keeps probe lengths short under the
+ * constant insert/erase churn of short-lived flows. The table doubles past
+ * a load of 1/2 and never shrinks, so its size follows the peak number of
+ * active flows.
+ */
+
+#ifndef SIM_FLOW_MAP_H
+#define SIM_FLOW_MAP_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/// @brief Flow ID -> Value map; Value must be default-constructible and copyable.
+template <class Value>
+class FlowMap {
+public:
+    static const uint32_t kEmptyKey = UINT32_MAX; // Reserved; never a flow ID
+
+private:
+    struct Slot {
+        uint32_t key;
+        Value value;
+    };
+
+    std::vector<Slot> slots;
+    size_t count = 0;
+    size_t mask = 0;
+    int shift = 64;
+
+    size_t home(uint32_t key) const {
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> shift);
+    }
+
+    void rehash(size_t capacity) {
+        std::vector<Slot> old;
+        old.swap(slots);
+        slots.assign(capacity, Slot{kEmptyKey, Value()});
+        mask = capacity - 1;
+        shift = 64;
+        for (size_t c = capacity; c > 1; c >>= 1) --shift;
+        for (const Slot& s : old) {
+            if (s.key == kEmptyKey) continue;
+            size_t i = home(s.key);
+            while (slots[i].key != kEmptyKey) i = (i + 1) & mask;
+            slots[i] = s;
+        }
+    }
+
+public:
+    FlowMap() { rehash(16); }
+
+    /// @brief Empties the map, keeping its storage.
+    void clear() {
+        for (Slot& s : slots) s.key = kEmptyKey;
+        count = 0;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    /// @brief Bytes held by the slot array.
+    size_t memoryBytes() const { return slots.size() * sizeof(Slot); }
+
+    /// @brief The record of `key`, or null; valid until the next insert or erase.
+    Value* find(uint32_t key) {
+        for (size_t i = home(key);; i = (i + 1) & mask) {
+            if (slots[i].key == key) return &slots[i].value;
+            if (slots[i].key == kEmptyKey) return nullptr;
+        }
+    }
+
+    const Value* find(uint32_t key) const {
+        return const_cast<FlowMap*>(this)->find(key);
+    }
+
+    /**
+     * @brief The record of `key`, default-constructed when new; valid until
+     * the next insert or erase.
+     */
+    Value& insert(uint32_t key) {
+        if (2 * (count + 1) > slots.size()) rehash(2 * slots.size());
+        size_t i = home(key);
+        for (; slots[i].key != kEmptyKey; i = (i + 1) & mask) {
+            if (slots[i].key == key) return slots[i].value;
+        }
+        slots[i].key = key;
+        slots[i].value = Value();
+        ++count;
+        return slots[i].value;
+    }
+
+    /// @brief Removes `key` if present.
+    void erase(uint32_t key) {
+        size_t i = home(key);
+        while (slots[i].key != key) {
+            if (slots[i].key == kEmptyKey) return;
+            i = (i + 1) & mask;
+        }
+        // Backward shift: pull later members of the probe run into the gap
+        // unless their home lies cyclically in (gap, j]
+        for (size_t j = (i + 1) & mask;; j = (j + 1) & mask) {
+            if (slots[j].key == kEmptyKey) break;
+            size_t h = home(slots[j].key);
+            bool stays = i <= j ? (i < h && h <= j) : (i < h || h <= j);
+            if (stays) continue;
+            slots[i] = slots[j];
+            i = j;
+        }
+        slots[i].key = kEmptyKey;
+        --count;
+    }
+
+    /// @brief Calls fn(key, value) for every record, in slot order.
+    template <class Fn>
+    void forEach(Fn fn) const {
+        for (const Slot& s : slots) {
+            if (s.key != kEmptyKey) fn(s.key, s.value);
+        }
+    }
+};
+
+#endif // SIM_FLOW_MAP_H
@@ -0,0 +1,410 @@
+/**
+ * @file flows.h
+ * @brief Flow engine: a single link fed by millions of short-lived flows.
+ * The Simulator keeps dense per-source state and one arrival chain per
+ * source, which is right for a handful of long-lived sources but grows with
+ * every flow ever seen. Here each source line is a flow class instead (see
+ * the FLOWS traffic model in config.h). Flows of a class start as a Poisson
+ * process over the class's activity window and each sends a geometric
+ * number of packets, Poisson at the class PACKET_RATE, the first one at the
+ * flow start.
+ *
+ * A flow exists only while it has packets left to send or in the system.
+ * Its record lives in a FlowMap keyed by a 32-bit flow ID, which is also the
+ * Packet::sourceID the discipline sees, and the event queue holds at most
+ * one pending packet arrival per flow. When the flow completes its record
+ * is folded into per-class aggregates (flow counts, completion-time and
+ * throughput histograms, streaming sums for Jain's index) and erased, so
+ * memory follows the number of concurrently active flows, not the total.
+ * Per-class packet counters use the Simulator's SourceStatsTable.
+ *
+ * A flow-mode Discipline has the engine Discipline interface except that
+ * enqueue takes the flow weight, enqueue(h, weight, onDrop), since there
+ * is no per-source configuration to read it from, and it reports the
+ * per-flow state it holds through trackedFlows() and trackedBytes().
+ * FlowFCFSDiscipline and FlowWFQDiscipline (wfq.h) are provided.
+ */
+
+#ifndef SIM_FLOWS_H
+#define SIM_FLOWS_H
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <memory>
+#include <limits>
+#include <stdexcept>
+#include <cmath>
+#include <cstdint>
+
+#include "simulator.h"
+#include "fcfs.h"
+#include "wfq.h"
+#include "flow_map.h"
+
+/// @brief FCFS for flow mode; FIFO service keeps no per-flow state.
+class FlowFCFSDiscipline : public FCFSDiscipline {
+public:
+    template <class OnDrop>
+    void enqueue(PacketHandle h, double, OnDrop onDrop) {
+        FCFSDiscipline::enqueue(h, onDrop);
+    }
+
+    size_t trackedFlows() const { return 0; }
+    size_t trackedBytes() const { return 0; }
+};
+
+/// @brief Derived per-class figures reported by printResults.
+struct FlowClassMetrics {
+    double weight;
+    long flowsStarted;
+    long flowsCompleted;
+    long flowsWithDrops;    // Completed flows that lost at least one packet
+    double dropRate;        // Packets
+    double avgDelay;        // Seconds per packet
+    double fctP50;          // Flow completion time, seconds
+    double fctP99;
+    double throughputP50;   // Bytes per second per completed flow
+};
+
+/// @brief System-level, flow-level and per-class results of one flow run.
+struct FlowMetrics {
+    double utilization = 0.0;
+    double avgDelay = 0.0;
+    double dropProbability = 0.0;
+    double fairness = 0.0;  // Jain's index over completed flows' throughput
+    long flowsStarted = 0;
+    long flowsCompleted = 0;
+    long activeAtEnd = 0;
+    long peakActive = 0;
+    size_t flowTableBytes = 0;
+    size_t schedulerBytes = 0;  // Per-flow state held by the discipline
+    size_t schedulerFlows = 0;  // Flows it still tracks at the end
+    std::vector<FlowClassMetrics> classes;
+};
+
+/// @brief Single-link engine over flow classes.
+template <class Discipline>
+class FlowSimulator {
+private:
+    /// @brief One flow class with its pending flow start.
+    struct FlowClass {
+        double flowGap;      // Mean time between flow starts
+        double packetGap;    // Mean time between packets of a flow
+        double lengthScale;  // 1 / -log(1 - 1/MEAN_PACKETS); 0 for single-packet flows
+        SizeRange sizes;
+        std::shared_ptr<const EmpiricalSizes> table; // Null draws uniform sizes
+        double weight;
+        double startTime;
+        double endTime;
+    };
+
+    /// @brief Live state of one active flow.
+    struct FlowRecord {
+        uint32_t cls;
+        uint32_t remaining;  // Packets not yet generated
+        uint32_t inSystem;   // Packets buffered or in transmission
+        uint32_t dropped;
+        double bytes;        // Delivered
+        double startTime;
+        double lastTime;     // Last departure or drop
+    };
+
+    /// @brief Completed-flow aggregates of one class.
+    struct ClassSketch {
+        long started = 0;
+        long completed = 0;
+        long withDrops = 0;
+        LogHistogram fct;
+        LogHistogram throughput;
+    };
+
+    double simulationTime = 0.0;
+    double linkCapacity = 0.0;
+    double currentTime = 0.0;
+    bool linkBusy = false;
+    long nextPacketId = 1;
+    uint32_t nextFlowId = 0;
+    uint64_t eventsProcessed = 0;
+    size_t peakActive = 0;
+    double jainSum = 0.0;   // Over completed flows of throughput (/ weight when weighted)
+    double jainSquares = 0.0;
+    long jainCount = 0;
+
+    std::vector<FlowClass> classes;
+    std::vector<ClassSketch> sketches;
+    FlowMap<FlowRecord> flows;
+    SourceStatsTable stats; // Per class
+    PacketPool pool;
+    Discipline packetBuffer;
+    BinaryHeapQueue eventQueue;
+    RandomSource rng;
+
+    void scheduleEvent(const Event& e) {
+        if (e.time <= simulationTime) eventQueue.push(e);
+    }
+
+    int drawSize(const FlowClass& c) {
+        return c.table ? c.table->sample(rng.uniform()) : rng.uniformInt(c.sizes.minSize, c.sizes.maxSize);
+    }
+
+    // Geometric on {1, 2, ...} with the class mean, by inversion of an exponential
+    uint32_t drawLength(const FlowClass& c) {
+        if (c.lengthScale == 0.0) return 1;
+        double extra = std::floor(rng.exponential() * c.lengthScale);
+        return extra >= 4294967294.0 ? UINT32_MAX : static_cast<uint32_t>(extra) + 1;
+    }
+
+    // Folds a flow with nothing left to send or deliver into its class and forgets it
+    void completeIfDone(uint32_t id, FlowRecord& f) {
+        if (f.remaining != 0 || f.inSystem != 0) return;
+        ClassSketch& s = sketches[f.cls];
+        ++s.completed;
+        if (f.dropped > 0) ++s.withDrops;
+        double fct = f.lastTime - f.startTime;
+        s.fct.record(fct);
+        if (fct > 0.0) {
+            double rate = f.bytes / fct;
+            s.throughput.record(rate);
+            double x = Discipline::weightedFairness ? rate / classes[f.cls].weight : rate;
+            jainSum += x;
+            jainSquares += x * x;
+            ++jainCount;
+        }
+        flows.erase(id);
+    }
+
+    void dropPacket(PacketHandle h) {
+        uint32_t id = static_cast<uint32_t>(pool[h].sourceID);
+        FlowRecord& f = *flows.find(id);
+        stats.packetsDropped[f.cls]++;
+        --f.inSystem;
+        ++f.dropped;
+        f.lastTime = currentTime;
+        pool.release(h);
+        completeIfDone(id, f);
+    }
+
+    void startNextTransmission() {
+        if (linkBusy || packetBuffer.empty()) return;
+        PacketHandle h = packetBuffer.dequeue();
+        linkBusy = true;
+        scheduleEvent(Event(Event::PACKET_DEPARTURE, currentTime + pool[h].size / linkCapacity, h));
+    }
+
+    void handleFlowArrival(uint32_t cls) {
+        const FlowClass& c = classes[cls];
+        double next = currentTime + rng.exponential() * c.flowGap;
+        if (next < c.endTime) scheduleEvent(Event(Event::FLOW_ARRIVAL, next, cls));
+
+        if (nextFlowId > static_cast<uint32_t>(std::numeric_limits<int>::max())) {
+            throw std::runtime_error("Flow mode ran out of flow IDs (2^31 flows)");
+        }
+        uint32_t id = nextFlowId++;
+        FlowRecord& f = flows.insert(id);
+        f = FlowRecord{cls, drawLength(c), 0, 0, 0.0, currentTime, currentTime};
+        if (flows.size() > peakActive) peakActive = flows.size();
+        ++sketches[cls].started;
+        handlePacketArrival(id);
+    }
+
+    void handlePacketArrival(uint32_t id) {
+        FlowRecord& f = *flows.find(id);
+        const FlowClass& c = classes[f.cls];
+        --f.remaining;
+        ++f.inSystem;
+        if (f.remaining > 0) scheduleEvent(Event(Event::PACKET_ARRIVAL, currentTime + rng.exponential() * c.packetGap, id));
+        // A flow cut off by the end of the run stays active; it is reported as such
+        stats.packetsGenerated[f.cls]++;
+
+        PacketHandle h = pool.allocate();
+        pool[h] = Packet{nextPacketId++, static_cast<int>(id), drawSize(c), currentTime, 0.0};
+        // The drop callback may complete and erase the flow, so `f` is not used past here
+        packetBuffer.enqueue(h, c.weight, [this](PacketHandle dropped) { dropPacket(dropped); });
+        startNextTransmission();
+    }
+
+    void handleDepartureEvent(const Event& e) {
+        linkBusy = false;
+        const Packet& p = pool[e.index];
+        uint32_t id = static_cast<uint32_t>(p.sourceID);
+        FlowRecord& f = *flows.find(id);
+        stats.recordDeparture(f.cls, p.size, currentTime - p.arrivalTime);
+        f.bytes += p.size;
+        f.lastTime = currentTime;
+        --f.inSystem;
+        pool.release(e.index);
+        completeIfDone(id, f);
+
+        startNextTransmission();
+    }
+
+public:
+    /**
+     * @brief Applies a configuration whose every source line is a flow class.
+     */
+    void configure(const Config& config) {
+        simulationTime = config.simulationTime;
+        linkCapacity = config.linkCapacity;
+        std::vector<std::shared_ptr<const EmpiricalSizes>> tables;
+        for (const auto& table : config.sizeTables) tables.push_back(std::make_shared<const EmpiricalSizes>(table));
+
+        classes.clear();
+        for (int i = 0; i < config.numSources; ++i) {
+            const SourceConfig& sc = config.sources[i];
+            TrafficModel model = trafficModel(config, i);
+            if (model.process != ArrivalProcess::FLOWS) {
+                throw std::runtime_error("Flow mode needs a flows field on every source line (source " +
+                                         std::to_string(i) + ")");
+            }
+            if (!(sc.weight > 0)) {
+                throw std::runtime_error("Flow classes need a positive weight (source " + std::to_string(i) + ")");
+            }
+            FlowClass c;
+            c.flowGap = 1.0 / model.param[0];
+            c.packetGap = 1.0 / sc.packetRate;
+            c.lengthScale = model.param[1] > 1.0 ? -1.0 / std::log1p(-1.0 / model.param[1]) : 0.0;
+            c.sizes = SizeRange{sc.minSize, sc.maxSize};
+            if (model.sizeTable >= 0) c.table = tables[model.sizeTable];
+            c.weight = sc.weight;
+            c.startTime = sc.startFraction * simulationTime;
+            c.endTime = sc.endFraction * simulationTime;
+            classes.push_back(c);
+        }
+        // Buffered packets, plus the one in transmission and the one arriving
+        pool.reset(bufferedPacketBound(config) + 2);
+        packetBuffer.configure(config, pool);
+    }
+
+    void loadConfig(const std::string& filename) {
+        configure(::loadConfig(filename));
+    }
+
+    /// @brief Selects the random engine; only the engine choice applies in flow mode.
+    void setRunOptions(const RunOptions& runOptions) {
+        rng.setEngine(runOptions.randomEngine);
+    }
+
+    void seed(uint64_t seedValue) {
+        rng.seed(seedValue);
+    }
+
+    /**
+     * @brief Executes the discrete-event simulation loop.
+     */
+    void run() {
+        currentTime = 0.0;
+        linkBusy = false;
+        nextPacketId = 1;
+        nextFlowId = 0;
+        eventsProcessed = 0;
+        peakActive = 0;
+        jainSum = jainSquares = 0.0;
+        jainCount = 0;
+        flows.clear();
+        eventQueue.clear();
+        stats.reset(classes.size());
+        sketches.assign(classes.size(), ClassSketch());
+
+        for (size_t i = 0; i < classes.size(); ++i) {
+            if (classes[i].startTime < classes[i].endTime) {
+                scheduleEvent(Event(Event::FLOW_ARRIVAL, classes[i].startTime, static_cast<uint32_t>(i)));
+            }
+        }
+        while (!eventQueue.empty()) {
+            Event e = eventQueue.pop();
+            currentTime = e.time;
+            if (e.type == Event::FLOW_ARRIVAL) {
+                handleFlowArrival(e.index);
+            } else if (e.type == Event::PACKET_ARRIVAL) {
+                handlePacketArrival(e.index);
+            } else {
+                handleDepartureEvent(e);
+            }
+            ++eventsProcessed;
+        }
+    }
+
+    /// @brief Number of events handled by the last run().
+    uint64_t eventCount() const { return eventsProcessed; }
+
+    /**
+     * @brief Calculates the system, flow and per-class metrics of the last run.
+     */
+    FlowMetrics metrics() const {
+        FlowMetrics m;
+        StatsTotals t = stats.totals();
+        m.utilization = (t.bytesTransmitted / linkCapacity) / simulationTime;
+        m.avgDelay = t.packetsTransmitted > 0 ? t.totalDelay / t.packetsTransmitted : 0.0;
+        m.dropProbability = t.packetsGenerated > 0 ? (double)t.packetsDropped / t.packetsGenerated : 0.0;
+        m.fairness = jainSquares > 0 ? (jainSum * jainSum) / (jainCount * jainSquares) : 0.0;
+        m.activeAtEnd = static_cast<long>(flows.size());
+        m.peakActive = static_cast<long>(peakActive);
+        m.flowTableBytes = flows.memoryBytes();
+        m.schedulerBytes = packetBuffer.trackedBytes();
+        m.schedulerFlows = packetBuffer.trackedFlows();
+
+        m.classes.reserve(classes.size());
+        for (size_t i = 0; i < classes.size(); ++i) {
+            const ClassSketch& s = sketches[i];
+            FlowClassMetrics cm;
+            cm.weight = classes[i].weight;
+            cm.flowsStarted = s.started;
+            cm.flowsCompleted = s.completed;
+            cm.flowsWithDrops = s.withDrops;
+            cm.dropRate = stats.packetsGenerated[i] > 0 ? (double)stats.packetsDropped[i] / stats.packetsGenerated[i] : 0.0;
+            cm.avgDelay = stats.packetsTransmitted[i] > 0 ? stats.totalDelay[i] / stats.packetsTransmitted[i] : 0.0;
+            cm.fctP50 = s.fct.quantile(0.5);
+            cm.fctP99 = s.fct.quantile(0.99);
+            cm.throughputP50 = s.throughput.quantile(0.5);
+            m.flowsStarted += s.started;
+            m.flowsCompleted += s.completed;
+            m.classes.push_back(cm);
+        }
+        return m;
+    }
+
+    /**
+     * @brief Calculates metrics and outputs them to the provided stream.
+     */
+    void printResults(std::ostream& out) const {
+        FlowMetrics m = metrics();
+
+        out << std::fixed << std::setprecision(6);
+        out << "## System-Level Performance Metrics (" << Discipline::name() << ", flow mode)\n"
+            << "1. Server Utilization:   " << m.utilization << "\n"
+            << "2. Avg. Packet Delay:    " << m.avgDelay << " s\n"
+            << "3. Packet Drop Prob.:    " << m.dropProbability << "\n"
+            << "4. Fairness Index:       " << m.fairness << " (over completed flows)\n\n";
+
+        out << "## Flow Statistics\n"
+            << "Flows started:          " << m.flowsStarted << "\n"
+            << "Flows completed:        " << m.flowsCompleted << "\n"
+            << "Active at end:          " << m.activeAtEnd << "\n"
+            << "Peak active flows:      " << m.peakActive << "\n"
+            << "Tracked flow state:     " << std::setprecision(1) << (m.flowTableBytes + m.schedulerBytes) / 1024.0
+            << " KB (flow table " << m.flowTableBytes / 1024.0 << " KB, scheduler "
+            << m.schedulerBytes / 1024.0 << " KB for " << m.schedulerFlows << " flows at end)\n\n";
+
+        out << "## Per-Class Statistics\n"
+            << "-------------------------------------------------------------------------------------------------------\n"
+            << "Cls | Weight |  Flows Done | With Drops | Drop Rate | Avg Delay (s) | FCT p50 (s) | FCT p99 (s) | Thruput p50 (B/s)\n"
+            << "-------------------------------------------------------------------------------------------------------\n";
+        for (size_t i = 0; i < m.classes.size(); ++i) {
+            const FlowClassMetrics& cm = m.classes[i];
+            out << std::setw(3) << i << " | "
+                << std::setw(6) << std::setprecision(2) << cm.weight << " | "
+                << std::setw(11) << cm.flowsCompleted << " | "
+                << std::setw(10) << cm.flowsWithDrops << " | "
+                << std::setw(9) << std::setprecision(4) << cm.dropRate << " | "
+                << std::setw(13) << std::setprecision(6) << cm.avgDelay << " | "
+                << std::setw(11) << cm.fctP50 << " | "
+                << std::setw(11) << cm.fctP99 << " | "
+                << std::setw(17) << std::setprecision(2) << cm.throughputP50 << "\n";
+        }
+        out << "-------------------------------------------------------------------------------------------------------\n"
+            << std::setprecision(6);
+    }
+};
+
+#endif // SIM_FLOWS_H
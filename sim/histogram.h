@@ -0,0 +1,211 @@
+/**
+ * @file histogram.h
+ * @brief Constant-memory log-bucketed histogram for delay percentiles.
+ * Buckets follow the HDR-histogram layout: a value's key is its IEEE-754
+ * exponent plus the top kSubBucketBits of its mantissa, so recording is a
+ * bit shift and an increment with no log() call. Each power of two is split
+ * into 64 linear sub-buckets, giving under 0.8% relative error at the
+ * bucket midpoint. A histogram starts as a short sorted list of occupied
+ * buckets, so the many lightly loaded sources of a large run stay at a few
+ * dozen bytes each. Past kSparseBuckets occupied buckets it switches to a
+ * dense array spanning the observed range. That range is capped at
+ * kMaxBuckets; beyond it the lowest buckets collapse into one, which keeps
+ * the tail accurate and bounds memory for any run length.
+ */
+
+#ifndef SIM_HISTOGRAM_H
+#define SIM_HISTOGRAM_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#include "checkpoint.h"
+
+/// @brief Streaming histogram of positive values with bounded relative error.
+class LogHistogram {
+public:
+    static const int kSubBucketBits = 6;      // 64 sub-buckets per power of two
+    static const size_t kMaxBuckets = 2048;   // 32 powers of two, 16 KB of counts
+    static const size_t kSparseBuckets = 32;  // Occupied buckets kept as a list
+
+private:
+    struct Bin {
+        int64_t key;
+        uint64_t count;
+    };
+
+    std::vector<Bin> sparse;      // Sorted by key; used until the histogram goes dense
+    std::vector<uint64_t> counts; // Dense form: counts[i] holds key minKey + i
+    bool dense = false;
+    int64_t minKey = 0;
+    uint64_t total = 0;
+    double minValue = 0.0;
+    double maxValue = 0.0;
+
+    static int64_t keyOf(double v) {
+        // Zero, denormal and NaN inputs share the smallest normal bucket
+        if (!(v >= 2.2250738585072014e-308)) v = 2.2250738585072014e-308;
+        uint64_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        return static_cast<int64_t>(bits >> (52 - kSubBucketBits));
+    }
+
+    static double valueOf(int64_t key) {
+        uint64_t bits = static_cast<uint64_t>(key) << (52 - kSubBucketBits);
+        double v;
+        std::memcpy(&v, &bits, sizeof(v));
+        return v;
+    }
+
+    // Makes room for `key` and returns its slot, collapsing low buckets if
+    // the range would exceed kMaxBuckets
+    size_t slotOf(int64_t key) {
+        if (counts.empty()) {
+            minKey = key;
+            counts.assign(1, 0);
+            return 0;
+        }
+        if (key < minKey) {
+            int64_t newMin = key;
+            int64_t maxKey = minKey + static_cast<int64_t>(counts.size()) - 1;
+            if (maxKey - newMin + 1 > static_cast<int64_t>(kMaxBuckets)) {
+                newMin = maxKey - static_cast<int64_t>(kMaxBuckets) + 1;
+            }
+            if (newMin < minKey) {
+                counts.insert(counts.begin(), static_cast<size_t>(minKey - newMin), 0);
+                minKey = newMin;
+            }
+            return key < minKey ? 0 : static_cast<size_t>(key - minKey);
+        }
+
+        size_t slot = static_cast<size_t>(key - minKey);
+        if (slot < counts.size()) return slot;
+        if (slot >= kMaxBuckets) {
+            // Fold everything below the new window into its first bucket
+            size_t shift = slot - kMaxBuckets + 1;
+            uint64_t folded = 0;
+            for (size_t i = 0; i < shift && i < counts.size(); ++i) folded += counts[i];
+            if (shift < counts.size()) {
+                counts.erase(counts.begin(), counts.begin() + shift);
+            } else {
+                counts.clear();
+            }
+            if (counts.empty()) counts.push_back(0);
+            counts[0] += folded;
+            minKey += static_cast<int64_t>(shift);
+            slot -= shift;
+        }
+        counts.resize(slot + 1, 0);
+        return slot;
+    }
+
+    void addBin(int64_t key, uint64_t n) {
+        if (dense) {
+            counts[slotOf(key)] += n;
+            return;
+        }
+        auto it = std::lower_bound(sparse.begin(), sparse.end(), key,
+                                   [](const Bin& b, int64_t k) { return b.key < k; });
+        if (it != sparse.end() && it->key == key) {
+            it->count += n;
+            return;
+        }
+        sparse.insert(it, Bin{key, n});
+        if (sparse.size() > kSparseBuckets) {
+            dense = true;
+            for (const Bin& b : sparse) counts[slotOf(b.key)] += b.count;
+            std::vector<Bin>().swap(sparse);
+        }
+    }
+
+    // Calls fn(key, count) for every occupied bucket in increasing key order
+    template <class Fn>
+    void forEachBin(Fn fn) const {
+        if (!dense) {
+            for (const Bin& b : sparse) fn(b.key, b.count);
+            return;
+        }
+        for (size_t i = 0; i < counts.size(); ++i) {
+            if (counts[i] != 0) fn(minKey + static_cast<int64_t>(i), counts[i]);
+        }
+    }
+
+public:
+    /// @brief Records one value.
+    void record(double v) {
+        if (total == 0 || v < minValue) minValue = v;
+        if (total == 0 || v > maxValue) maxValue = v;
+        ++total;
+
+        int64_t key = keyOf(v);
+        // Keys below minKey wrap around to large slots and take the slow path
+        size_t slot = static_cast<size_t>(key - minKey);
+        if (dense && slot < counts.size()) {
+            ++counts[slot];
+            return;
+        }
+        addBin(key, 1);
+    }
+
+    /// @brief Adds every value recorded in `other`.
+    void merge(const LogHistogram& other) {
+        if (other.total == 0) return;
+        other.forEachBin([this](int64_t key, uint64_t n) { addBin(key, n); });
+        if (total == 0 || other.minValue < minValue) minValue = other.minValue;
+        if (total == 0 || other.maxValue > maxValue) maxValue = other.maxValue;
+        total += other.total;
+    }
+
+    void clear() {
+        sparse.clear();
+        counts.clear();
+        dense = false;
+        total = 0;
+    }
+
+    uint64_t count() const { return total; }
+
+    void saveState(StateWriter& out) const {
+        out.put(dense, minKey, total, minValue, maxValue);
+        out.putVector(sparse);
+        out.putVector(counts);
+    }
+
+    void loadState(StateReader& in) {
+        in.get(dense, minKey, total, minValue, maxValue);
+        in.getVector(sparse);
+        in.getVector(counts);
+    }
+
+    /**
+     * @brief Value at quantile q in [0, 1]: the midpoint of the bucket that
+     * holds the ceil(q * count)-th smallest value, clamped to the observed
+     * range. Returns 0 when nothing has been recorded.
+     */
+    double quantile(double q) const {
+        if (total == 0) return 0.0;
+        double target = std::ceil(q * static_cast<double>(total));
+        uint64_t rank = target < 1.0 ? 1 : static_cast<uint64_t>(target);
+        if (rank > total) rank = total;
+
+        uint64_t seen = 0;
+        bool found = false;
+        double result = maxValue;
+        forEachBin([&](int64_t key, uint64_t n) {
+            if (found) return;
+            seen += n;
+            if (seen >= rank) {
+                found = true;
+                double mid = 0.5 * (valueOf(key) + valueOf(key + 1));
+                result = mid < minValue ? minValue : (mid > maxValue ? maxValue : mid);
+            }
+        });
+        return result;
+    }
+};
+
+#endif // SIM_HISTOGRAM_H
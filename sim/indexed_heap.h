@@ -0,0 +1,144 @@
+/**
+ * @file indexed_heap.h
+ * @brief Addressable binary min-heap over small integer IDs.
+ * Each ID (e.g. a source) appears at most once, keyed by a double. A position
+ * index allows the key of any member to be changed or the member removed in
+ * O(log n), which plain std::priority_queue cannot do.
+ */
+
+#ifndef SIM_INDEXED_HEAP_H
+#define SIM_INDEXED_HEAP_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+
+#include "checkpoint.h"
+
+class IndexedMinHeap {
+private:
+    struct Entry {
+        double key;
+        uint32_t id;
+    };
+
+    enum : uint32_t { kAbsent = UINT32_MAX };
+
+    std::vector<Entry> heap;
+    std::vector<uint32_t> position; // position[id] = slot in heap, or kAbsent
+
+    void place(size_t slot, const Entry& e) {
+        heap[slot] = e;
+        position[e.id] = static_cast<uint32_t>(slot);
+    }
+
+    void siftUp(size_t slot) {
+        Entry e = heap[slot];
+        while (slot > 0) {
+            size_t parent = (slot - 1) / 2;
+            if (!(e.key < heap[parent].key)) break;
+            place(slot, heap[parent]);
+            slot = parent;
+        }
+        place(slot, e);
+    }
+
+    void siftDown(size_t slot) {
+        Entry e = heap[slot];
+        size_t n = heap.size();
+        for (;;) {
+            size_t child = 2 * slot + 1;
+            if (child >= n) break;
+            if (child + 1 < n && heap[child + 1].key < heap[child].key) ++child;
+            if (!(heap[child].key < e.key)) break;
+            place(slot, heap[child]);
+            slot = child;
+        }
+        place(slot, e);
+    }
+
+public:
+    /// @brief Empties the heap and sizes it for IDs in [0, capacity).
+    void reset(size_t capacity) {
+        heap.clear();
+        heap.reserve(capacity);
+        position.assign(capacity, kAbsent);
+    }
+
+    bool empty() const { return heap.empty(); }
+    size_t size() const { return heap.size(); }
+    bool contains(uint32_t id) const { return position[id] != kAbsent; }
+
+    uint32_t top() const { return heap.front().id; }
+    double topKey() const { return heap.front().key; }
+    double key(uint32_t id) const { return heap[position[id]].key; }
+
+    /// @brief Smallest key other than the top's (a child of the root), or
+    /// +infinity when the top is the only member.
+    double secondKey() const {
+        size_t n = heap.size();
+        if (n < 2) return HUGE_VAL;
+        if (n == 2 || heap[1].key < heap[2].key) return heap[1].key;
+        return heap[2].key;
+    }
+
+    /// @brief Checkpoint support; the capacity must match the reset() one.
+    void saveState(StateWriter& out) const {
+        out.putVector(heap);
+        out.putVector(position);
+    }
+
+    void loadState(StateReader& in) {
+        size_t capacity = position.size();
+        in.getVector(heap);
+        in.getVector(position, capacity);
+    }
+
+    void push(uint32_t id, double key) {
+        heap.push_back(Entry{key, id});
+        position[id] = static_cast<uint32_t>(heap.size() - 1);
+        siftUp(heap.size() - 1);
+    }
+
+    void pop() {
+        position[heap.front().id] = kAbsent;
+        Entry last = heap.back();
+        heap.pop_back();
+        if (!heap.empty()) {
+            place(0, last);
+            siftDown(0);
+        }
+    }
+
+    /// @brief Replaces the top member with another ID (or the same one) and
+    /// restores the heap with a single sift.
+    void replaceTop(uint32_t id, double key) {
+        position[heap.front().id] = kAbsent;
+        place(0, Entry{key, id});
+        siftDown(0);
+    }
+
+    /// @brief Changes the key of a member in either direction.
+    void update(uint32_t id, double key) {
+        size_t slot = position[id];
+        double old = heap[slot].key;
+        heap[slot].key = key;
+        if (key < old) siftUp(slot);
+        else siftDown(slot);
+    }
+
+    void remove(uint32_t id) {
+        size_t slot = position[id];
+        position[id] = kAbsent;
+        Entry last = heap.back();
+        heap.pop_back();
+        if (slot < heap.size()) {
+            place(slot, last);
+            siftUp(slot);
+            siftDown(position[last.id]);
+        }
+    }
+};
+
+#endif // SIM_INDEXED_HEAP_H
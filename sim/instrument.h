@@ -0,0 +1,155 @@
+/**
+ * @file instrument.h
+ * @brief Compile-time-optional counters on the engine's hot path.
+ * Build with -DSIM_INSTRUMENT to count handler calls by event type, track
+ * the high-water marks of the event queue and the discipline buffer, count
+ * drops by the path that made them and time every handler in TSC cycles
+ * (steady_clock nanoseconds off x86). Without the flag EngineCounters is an
+ * empty class whose inline methods compile to nothing, so the handlers carry
+ * no cost. Cycle counts are inclusive: the transmission start is also part
+ * of the arrival or departure that triggered it.
+ */
+
+#ifndef SIM_INSTRUMENT_H
+#define SIM_INSTRUMENT_H
+
+#include <ostream>
+#include <iomanip>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef SIM_INSTRUMENT
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+#endif
+
+/// @brief Timed sections of the engine.
+enum class Handler : int {
+    RUN_LOOP,       // advance(), one call per run segment
+    ARRIVAL,
+    DEPARTURE,
+    TRANSMISSION,   // startNextTransmission()
+    REPLAY_ARRIVAL,
+    METRICS_SAMPLE,
+    RUN_CONTROL,
+    COUNT
+};
+
+/// @brief Where a packet was dropped.
+enum class DropPath : int { BUFFER, AQM_ENQUEUE, AQM_DEQUEUE, COUNT };
+
+#ifdef SIM_INSTRUMENT
+
+inline uint64_t readCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+/// @brief Hot-path counters of one Simulator, reset by start().
+class EngineCounters {
+private:
+    static const int kHandlers = static_cast<int>(Handler::COUNT);
+    static const int kDropPaths = static_cast<int>(DropPath::COUNT);
+
+    uint64_t calls[kHandlers];
+    uint64_t cycles[kHandlers];
+    uint64_t drops[kDropPaths];
+    size_t queueHighWater;
+    size_t bufferHighWater;
+
+public:
+    static const bool enabled = true;
+
+    EngineCounters() { reset(); }
+
+    void reset() {
+        for (int i = 0; i < kHandlers; ++i) calls[i] = cycles[i] = 0;
+        for (int i = 0; i < kDropPaths; ++i) drops[i] = 0;
+        queueHighWater = bufferHighWater = 0;
+    }
+
+    /// @brief Counts one call of a handler and its cycles up to end of scope.
+    class Scope {
+    private:
+        EngineCounters& counters;
+        int handler;
+        uint64_t start;
+
+    public:
+        Scope(EngineCounters& c, Handler h) : counters(c), handler(static_cast<int>(h)), start(readCycles()) {}
+        ~Scope() {
+            counters.cycles[handler] += readCycles() - start;
+            ++counters.calls[handler];
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    void drop(DropPath path) { ++drops[static_cast<int>(path)]; }
+    void queueDepth(size_t n) { if (n > queueHighWater) queueHighWater = n; }
+    void bufferDepth(size_t n) { if (n > bufferHighWater) bufferHighWater = n; }
+
+    uint64_t callCount(Handler h) const { return calls[static_cast<int>(h)]; }
+    uint64_t cycleCount(Handler h) const { return cycles[static_cast<int>(h)]; }
+    uint64_t dropCount(DropPath path) const { return drops[static_cast<int>(path)]; }
+    size_t queueHighWaterMark() const { return queueHighWater; }
+    size_t bufferHighWaterMark() const { return bufferHighWater; }
+
+    /**
+     * @brief Outputs the counters in the printResults layout.
+     */
+    void print(std::ostream& out) const {
+        static const char* const names[kHandlers] = {
+            "run loop", "arrival", "departure", "transmission", "replay arrival", "metrics sample", "run control"
+        };
+        out << "\n## Engine Instrumentation (cycles are inclusive)\n"
+            << "------------------------------------------------------------\n"
+            << "Handler        |        Calls |           Cycles | Cycles/call\n"
+            << "------------------------------------------------------------\n";
+        for (int i = 0; i < kHandlers; ++i) {
+            if (calls[i] == 0) continue;
+            out << std::left << std::setw(14) << names[i] << std::right << " | "
+                << std::setw(12) << calls[i] << " | "
+                << std::setw(16) << cycles[i] << " | "
+                << std::setw(11) << std::setprecision(1) << static_cast<double>(cycles[i]) / calls[i] << "\n";
+        }
+        out << "------------------------------------------------------------\n"
+            << "Event queue high-water: " << queueHighWater << " events\n"
+            << "Buffer high-water:      " << bufferHighWater << " packets\n"
+            << "Drops by path:          buffer " << drops[static_cast<int>(DropPath::BUFFER)]
+            << ", AQM enqueue " << drops[static_cast<int>(DropPath::AQM_ENQUEUE)]
+            << ", AQM dequeue " << drops[static_cast<int>(DropPath::AQM_DEQUEUE)] << "\n"
+            << std::setprecision(6);
+    }
+};
+
+#else
+
+/// @brief Stand-in without SIM_INSTRUMENT; every call compiles away.
+class EngineCounters {
+public:
+    static const bool enabled = false;
+
+    void reset() {}
+
+    class Scope {
+    public:
+        Scope(EngineCounters&, Handler) {}
+    };
+
+    void drop(DropPath) {}
+    void queueDepth(size_t) {}
+    void bufferDepth(size_t) {}
+    void print(std::ostream&) const {}
+};
+
+#endif // SIM_INSTRUMENT
+
+#endif // SIM_INSTRUMENT_H
@@ -0,0 +1,81 @@
+/**
+ * @file mapped_file.h
+ * @brief Read-only memory mapping of an input file.
+ * Large inputs (packet traces, replay captures) are read through the page
+ * cache rather than copied into the heap. Sequential readers can hand back
+ * the pages they have consumed, so resident memory stays flat however
+ * large the file is.
+ */
+
+#ifndef SIM_MAPPED_FILE_H
+#define SIM_MAPPED_FILE_H
+
+#include <string>
+#include <cstddef>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/// @brief A whole file mapped PROT_READ for sequential access.
+class MappedFile {
+private:
+    void* mapping = MAP_FAILED;
+    size_t bytes = 0;
+    size_t released = 0; // Prefix already handed back to the kernel
+
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path) { open(path); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    void open(const std::string& path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Could not open file: " + path);
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Could not stat file: " + path);
+        }
+        bytes = static_cast<size_t>(st.st_size);
+        released = 0;
+        if (bytes > 0) {
+            mapping = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Could not map file: " + path);
+            }
+            madvise(mapping, bytes, MADV_SEQUENTIAL);
+        }
+        ::close(fd);
+    }
+
+    void close() {
+        if (mapping != MAP_FAILED) munmap(mapping, bytes);
+        mapping = MAP_FAILED;
+        bytes = 0;
+    }
+
+    const char* data() const { return mapping == MAP_FAILED ? nullptr : static_cast<const char*>(mapping); }
+    size_t size() const { return bytes; }
+
+    /**
+     * @brief Drops the resident pages of [0, offset); they are re-read from
+     * disk if touched again. Cheap to call often: it acts in 64 MB steps.
+     */
+    void releaseBefore(size_t offset) {
+        const size_t kStep = size_t(64) << 20;
+        if (mapping == MAP_FAILED || offset < released + kStep) return;
+        size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t end = offset / page * page;
+        madvise(static_cast<char*>(mapping) + released, end - released, MADV_DONTNEED);
+        released = end;
+    }
+};
+
+#endif // SIM_MAPPED_FILE_H
@@ -0,0 +1,132 @@
+/**
+ * @file packet_pool.h
+ * @brief Preallocated storage for every packet the simulator holds.
+ * Packets live in one arena for their whole stay (buffered or in
+ * transmission); buffers and events refer to them by 32-bit handle. A
+ * parallel array of next-links lets buffers chain handles into intrusive
+ * FIFOs, so the steady state performs no heap allocation.
+ */
+
+#ifndef SIM_PACKET_POOL_H
+#define SIM_PACKET_POOL_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "checkpoint.h"
+
+/// @brief Represents a single network packet.
+struct Packet {
+    long id;
+    int sourceID;
+    int size;                 // Packet size in bytes
+    double arrivalTime;       // Time the packet entered the system
+    double virtualFinishTime; // Scheduling tag (WFQ VFT); unused by FCFS
+};
+
+typedef uint32_t PacketHandle;
+static const PacketHandle kNullPacket = UINT32_MAX;
+
+/// @brief Free-list arena of Packets addressed by PacketHandle.
+class PacketPool {
+private:
+    std::vector<Packet> packets;
+    std::vector<PacketHandle> links; // Free-list link, or next packet in a buffer FIFO
+    PacketHandle freeHead = kNullPacket;
+    size_t inUse = 0;
+
+    void grow(size_t capacity) {
+        size_t old = packets.size();
+        packets.resize(capacity);
+        links.resize(capacity);
+        for (size_t i = capacity; i-- > old;) {
+            links[i] = freeHead;
+            freeHead = static_cast<PacketHandle>(i);
+        }
+    }
+
+public:
+    /**
+     * @brief Releases every packet and ensures room for `capacity` of them.
+     * Existing storage is kept, so a reused simulator does not reallocate.
+     */
+    void reset(size_t capacity) {
+        freeHead = kNullPacket;
+        inUse = 0;
+        size_t n = packets.size();
+        for (size_t i = n; i-- > 0;) {
+            links[i] = freeHead;
+            freeHead = static_cast<PacketHandle>(i);
+        }
+        if (capacity > n) grow(capacity);
+    }
+
+    /// @brief Takes a slot; the pool doubles if the estimate was too small.
+    PacketHandle allocate() {
+        if (freeHead == kNullPacket) grow(packets.empty() ? 16 : 2 * packets.size());
+        PacketHandle h = freeHead;
+        freeHead = links[h];
+        links[h] = kNullPacket;
+        ++inUse;
+        return h;
+    }
+
+    void release(PacketHandle h) {
+        links[h] = freeHead;
+        freeHead = h;
+        --inUse;
+    }
+
+    Packet& operator[](PacketHandle h) { return packets[h]; }
+    const Packet& operator[](PacketHandle h) const { return packets[h]; }
+
+    /// @brief Intrusive link for buffers that chain packets into FIFOs.
+    PacketHandle& next(PacketHandle h) { return links[h]; }
+
+    size_t size() const { return inUse; }
+    size_t capacity() const { return packets.size(); }
+
+    /// @brief Checkpoint support: every slot, so that handles stay valid.
+    void saveState(StateWriter& out) const {
+        out.putVector(packets);
+        out.putVector(links);
+        out.put(freeHead, inUse);
+    }
+
+    void loadState(StateReader& in) {
+        in.getVector(packets);
+        in.getVector(links, packets.size());
+        in.get(freeHead, inUse);
+    }
+};
+
+/// @brief FIFO of packets chained through the PacketPool's links.
+struct PacketFifo {
+    PacketHandle head = kNullPacket;
+    PacketHandle tail = kNullPacket;
+
+    bool empty() const { return head == kNullPacket; }
+
+    /// @brief Appends h; returns true if the FIFO was empty.
+    bool pushBack(PacketPool& pool, PacketHandle h) {
+        pool.next(h) = kNullPacket;
+        if (tail == kNullPacket) {
+            head = tail = h;
+            return true;
+        }
+        pool.next(tail) = h;
+        tail = h;
+        return false;
+    }
+
+    /// @brief Unlinks and returns the head; the FIFO must not be empty.
+    PacketHandle popFront(PacketPool& pool) {
+        PacketHandle h = head;
+        head = pool.next(h);
+        if (head == kNullPacket) tail = kNullPacket;
+        return h;
+    }
+};
+
+#endif // SIM_PACKET_POOL_H
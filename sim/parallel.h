@@ -0,0 +1,132 @@
+/**
+ * @file parallel.h
+ * @brief Minimal work-sharing thread pool for independent simulation jobs,
+ * plus the synchronization pieces of the parallel topology engine.
+ */
+
+#ifndef SIM_PARALLEL_H
+#define SIM_PARALLEL_H
+
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+/**
+ * @brief Runs fn(index, worker) for every index in [0, count) on up to
+ * `threads` workers. Workers pull the next index from a shared counter, so
+ * uneven jobs balance themselves. The first exception thrown by any job is
+ * rethrown on the calling thread once all workers have stopped.
+ */
+template <class Fn>
+void parallelFor(size_t count, unsigned threads, Fn fn) {
+    unsigned workers = static_cast<unsigned>(std::min<size_t>(std::max(1u, threads), count));
+    std::atomic<size_t> next(0);
+    std::atomic<bool> failed(false);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    auto work = [&](unsigned worker) {
+        for (;;) {
+            size_t index = next.fetch_add(1);
+            if (index >= count || failed.load()) return;
+            try {
+                fn(index, worker);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) error = std::current_exception();
+                failed.store(true);
+            }
+        }
+    };
+
+    if (workers <= 1) {
+        work(0);
+    } else {
+        std::vector<std::thread> pool;
+        for (unsigned w = 0; w < workers; ++w) pool.emplace_back(work, w);
+        for (auto& t : pool) t.join();
+    }
+    if (error) std::rethrow_exception(error);
+}
+
+/**
+ * @brief Bounded lock-free single-producer single-consumer ring.
+ * The producer owns `tail` and the consumer owns `head`; each publishes its
+ * index with release ordering and reads the other's with acquire. The two
+ * indices are padded onto separate cache lines. Capacity is a power of two.
+ */
+template <class T>
+class SpscChannel {
+private:
+    std::vector<T> slots;
+    size_t mask;
+    std::atomic<size_t> head;
+    char padHead[64];
+    std::atomic<size_t> tail;
+    char padTail[64];
+
+public:
+    explicit SpscChannel(size_t capacity = 4096) : head(0), tail(0) {
+        size_t n = 1;
+        while (n < capacity) n <<= 1;
+        slots.resize(n);
+        mask = n - 1;
+    }
+
+    /// @brief Producer side; false when the ring is full.
+    bool tryPush(const T& value) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) > mask) return false;
+        slots[t & mask] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// @brief Consumer side; false when the ring is empty.
+    bool tryPop(T& value) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        value = slots[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+/**
+ * @brief Reusable spinning barrier for a fixed set of threads. Waiting
+ * threads run idle() while they spin, which lets them keep draining their
+ * inbound channels so that no producer stays blocked on a full ring.
+ */
+class SpinBarrier {
+private:
+    unsigned parties;
+    std::atomic<unsigned> arrived;
+    std::atomic<unsigned> generation;
+
+public:
+    explicit SpinBarrier(unsigned n) : parties(n), arrived(0), generation(0) {}
+
+    template <class Idle>
+    void wait(Idle idle) {
+        unsigned gen = generation.load(std::memory_order_acquire);
+        if (arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == parties) {
+            arrived.store(0, std::memory_order_relaxed);
+            generation.fetch_add(1, std::memory_order_release);
+            return;
+        }
+        while (generation.load(std::memory_order_acquire) == gen) {
+            idle();
+            std::this_thread::yield();
+        }
+    }
+
+    void wait() {
+        wait([] {});
+    }
+};
+
+#endif // SIM_PARALLEL_H
@@ -0,0 +1,289 @@
+/**
+ * @file random.h
+ * @brief Random engines and batched variate generation.
+ * The simulator draws three kinds of variates per packet: an exponential
+ * inter-arrival gap, a uniform packet size and (in aggregated mode) a uniform
+ * source pick. RandomSource pre-generates standard exponential and uniform
+ * variates in fixed blocks, with the engine selected once per block rather
+ * than per draw, so the refill loops are tight and vectorizable. Per-source
+ * rates and size ranges are applied when a variate is consumed: an Exp(rate)
+ * gap is a standard exponential divided by rate.
+ * Engines expose getState/setState so that a checkpoint restores the exact
+ * stream, buffered variates included.
+ */
+
+#ifndef SIM_RANDOM_H
+#define SIM_RANDOM_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <random>
+#include <sstream>
+#include <string>
+#include <stdexcept>
+
+#include "checkpoint.h"
+
+/// @brief SplitMix64, used to expand a single seed into engine state.
+inline uint64_t splitMix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/// @brief xoshiro256++ (Blackman & Vigna), 256-bit state, period 2^256 - 1.
+class Xoshiro256pp {
+private:
+    uint64_t s[4];
+
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+public:
+    typedef uint64_t result_type;
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+
+    explicit Xoshiro256pp(uint64_t seedValue = 1) { seed(seedValue); }
+
+    void seed(uint64_t seedValue) {
+        uint64_t sm = seedValue;
+        for (auto& word : s) word = splitMix64(sm);
+    }
+
+    void getState(uint64_t out[4]) const {
+        for (int i = 0; i < 4; ++i) out[i] = s[i];
+    }
+
+    void setState(const uint64_t in[4]) {
+        for (int i = 0; i < 4; ++i) s[i] = in[i];
+    }
+
+    result_type operator()() {
+        uint64_t result = rotl(s[0] + s[3], 23) + s[0];
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+};
+
+#ifdef __SIZEOF_INT128__
+#define SIM_HAVE_PCG64 1
+
+/**
+ * @brief PCG64 (XSL-RR 128/64, O'Neill), 128-bit LCG state with its own
+ * stream. Needs the GCC/Clang unsigned __int128, so it is compiled only
+ * where the compiler provides one.
+ */
+class Pcg64 {
+private:
+    __extension__ typedef unsigned __int128 u128;
+    u128 state = 0;
+    u128 increment = 1;
+
+    static u128 multiplier() {
+        return (static_cast<u128>(0x2360ED051FC65DA4ULL) << 64) | 0x4385DF649FCCF645ULL;
+    }
+
+public:
+    typedef uint64_t result_type;
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+
+    explicit Pcg64(uint64_t seedValue = 1) { seed(seedValue); }
+
+    void seed(uint64_t seedValue) {
+        uint64_t sm = seedValue;
+        u128 initState = (static_cast<u128>(splitMix64(sm)) << 64) | splitMix64(sm);
+        u128 stream = (static_cast<u128>(splitMix64(sm)) << 64) | splitMix64(sm);
+        state = 0;
+        increment = (stream << 1) | 1;
+        (*this)();
+        state += initState;
+        (*this)();
+    }
+
+    /// @brief State then increment, high word first.
+    void getState(uint64_t out[4]) const {
+        out[0] = static_cast<uint64_t>(state >> 64);
+        out[1] = static_cast<uint64_t>(state);
+        out[2] = static_cast<uint64_t>(increment >> 64);
+        out[3] = static_cast<uint64_t>(increment);
+    }
+
+    void setState(const uint64_t in[4]) {
+        state = (static_cast<u128>(in[0]) << 64) | in[1];
+        increment = (static_cast<u128>(in[2]) << 64) | in[3];
+    }
+
+    result_type operator()() {
+        u128 old = state;
+        state = old * multiplier() + increment;
+        uint64_t xored = static_cast<uint64_t>(old >> 64) ^ static_cast<uint64_t>(old);
+        unsigned rot = static_cast<unsigned>(old >> 122);
+        return (xored >> rot) | (xored << ((64 - rot) & 63));
+    }
+};
+#endif // __SIZEOF_INT128__
+
+/// @brief Engines selectable at run time.
+enum class RandomEngine { MINSTD, XOSHIRO256PP, PCG64 };
+
+inline RandomEngine parseRandomEngine(const std::string& name) {
+    if (name == "minstd") return RandomEngine::MINSTD;
+    if (name == "xoshiro") return RandomEngine::XOSHIRO256PP;
+#ifdef SIM_HAVE_PCG64
+    if (name == "pcg") return RandomEngine::PCG64;
+#else
+    if (name == "pcg") throw std::invalid_argument("This build has no PCG64: the compiler lacks unsigned __int128");
+#endif
+    throw std::invalid_argument("Unknown random engine: " + name);
+}
+
+/**
+ * @brief One simulator's random stream with block-buffered variates.
+ */
+class RandomSource {
+public:
+    static const size_t kBlock = 256;
+
+private:
+    RandomEngine engine = RandomEngine::XOSHIRO256PP;
+    std::minstd_rand minstd;
+    Xoshiro256pp xoshiro;
+#ifdef SIM_HAVE_PCG64
+    Pcg64 pcg;
+#endif
+
+    double exponentials[kBlock]; // Standard Exp(1) variates
+    double uniforms[kBlock];     // U[0, 1)
+    size_t nextExponential = kBlock;
+    size_t nextUniform = kBlock;
+
+    // 53 random bits mapped onto [0, 1)
+    static double unit64(uint64_t x) { return (x >> 11) * (1.0 / 9007199254740992.0); }
+
+    template <class Engine>
+    static void fillWith64(Engine& gen, double* out) {
+        for (size_t i = 0; i < kBlock; ++i) out[i] = unit64(gen());
+    }
+
+    void fillUniforms(double* out) {
+        switch (engine) {
+            case RandomEngine::MINSTD: {
+                // minstd yields [1, 2^31 - 2]
+                const double scale = 1.0 / (std::minstd_rand::max() - std::minstd_rand::min() + 1.0);
+                for (size_t i = 0; i < kBlock; ++i) out[i] = (minstd() - std::minstd_rand::min()) * scale;
+                break;
+            }
+            case RandomEngine::XOSHIRO256PP: fillWith64(xoshiro, out); break;
+#ifdef SIM_HAVE_PCG64
+            case RandomEngine::PCG64: fillWith64(pcg, out); break;
+#else
+            case RandomEngine::PCG64: break; // Rejected by parseRandomEngine and loadState
+#endif
+        }
+    }
+
+    void refillExponentials() {
+        fillUniforms(exponentials);
+        // u is in [0, 1), so 1 - u is in (0, 1] and the log stays finite
+        for (size_t i = 0; i < kBlock; ++i) exponentials[i] = -std::log1p(-exponentials[i]);
+        nextExponential = 0;
+    }
+
+    void refillUniforms() {
+        fillUniforms(uniforms);
+        nextUniform = 0;
+    }
+
+public:
+    RandomSource() { seed(1); }
+
+    void setEngine(RandomEngine e) {
+        engine = e;
+        nextExponential = nextUniform = kBlock;
+    }
+    RandomEngine engineKind() const { return engine; }
+
+    void seed(uint64_t seedValue) {
+        std::seed_seq seq{static_cast<uint32_t>(seedValue), static_cast<uint32_t>(seedValue >> 32)};
+        minstd.seed(seq);
+        xoshiro.seed(seedValue);
+#ifdef SIM_HAVE_PCG64
+        pcg.seed(seedValue);
+#endif
+        nextExponential = nextUniform = kBlock;
+    }
+
+    /// @brief Standard exponential variate; divide by a rate for Exp(rate).
+    double exponential() {
+        if (nextExponential == kBlock) refillExponentials();
+        return exponentials[nextExponential++];
+    }
+
+    /// @brief Uniform variate on [0, 1).
+    double uniform() {
+        if (nextUniform == kBlock) refillUniforms();
+        return uniforms[nextUniform++];
+    }
+
+    /**
+     * @brief Checkpoint support: the engine selection, every engine's state
+     * and the variates not yet consumed from the current blocks.
+     */
+    void saveState(StateWriter& out) const {
+        std::ostringstream minstdText;
+        minstdText << minstd; // The standard gives its state no other accessor
+        uint64_t xoshiroState[4], pcgState[4] = {0, 0, 0, 1};
+        xoshiro.getState(xoshiroState);
+#ifdef SIM_HAVE_PCG64
+        pcg.getState(pcgState);
+#endif
+        out.put(engine, xoshiroState, pcgState);
+        out.putString(minstdText.str());
+
+        out.put(static_cast<uint32_t>(nextExponential), static_cast<uint32_t>(nextUniform));
+        for (size_t i = nextExponential; i < kBlock; ++i) out.put(exponentials[i]);
+        for (size_t i = nextUniform; i < kBlock; ++i) out.put(uniforms[i]);
+    }
+
+    void loadState(StateReader& in) {
+        uint64_t xoshiroState[4], pcgState[4];
+        in.get(engine, xoshiroState, pcgState);
+        if (engine != RandomEngine::MINSTD && engine != RandomEngine::XOSHIRO256PP && engine != RandomEngine::PCG64) {
+            throw std::runtime_error("Corrupt random engine state in checkpoint");
+        }
+        std::istringstream minstdText(in.getString());
+        minstdText >> minstd;
+        if (!minstdText) throw std::runtime_error("Corrupt random engine state in checkpoint");
+        xoshiro.setState(xoshiroState);
+#ifdef SIM_HAVE_PCG64
+        pcg.setState(pcgState);
+#else
+        if (engine == RandomEngine::PCG64) throw std::runtime_error("Checkpoint uses PCG64, which this build lacks");
+#endif
+
+        uint32_t e = 0, u = 0;
+        in.get(e, u);
+        if (e > kBlock || u > kBlock) throw std::runtime_error("Corrupt random engine state in checkpoint");
+        nextExponential = e;
+        nextUniform = u;
+        for (size_t i = nextExponential; i < kBlock; ++i) in.get(exponentials[i]);
+        for (size_t i = nextUniform; i < kBlock; ++i) in.get(uniforms[i]);
+    }
+
+    /// @brief Uniform integer on [lo, hi].
+    int uniformInt(int lo, int hi) {
+        int v = lo + static_cast<int>(uniform() * (static_cast<double>(hi) - lo + 1.0));
+        return v > hi ? hi : v;
+    }
+};
+
+#endif // SIM_RANDOM_H
@@ -0,0 +1,295 @@
+/**
+ * @file rare_event.h
+ * @brief Importance-sampling estimator of small FCFS drop probabilities.
+ * Drops that occur once in 1e9 arrivals are out of reach of run(). The
+ * single-link FCFS system regenerates whenever an arrival finds it empty,
+ * so the drop probability is the ratio
+ *   p = E[drops per busy cycle] / E[arrivals per busy cycle].
+ * The denominator is estimated from ordinary busy cycles. The numerator
+ * comes from cycles simulated with the superposed Poisson rate twisted from
+ * lambda to lambda' > lambda, which makes the buffer fill. Each twisted gap
+ * x multiplies the cycle's likelihood ratio by
+ *   (lambda / lambda') exp(-(lambda - lambda') x),
+ * and at the first drop the cycle reverts to the original rate with the
+ * ratio frozen. Drops are weighted by that ratio, which keeps the estimate
+ * unbiased. The default twist swaps the arrival and service rates,
+ * lambda' = mu^2 / lambda, which is asymptotically optimal for M/M/1/K
+ * (Parekh & Walrand, 1989). Sources must be Poisson; empirical sizes are
+ * drawn like the engine's. Cycles need no event queue: under FCFS, the
+ * departure times of the packets in the system form a FIFO.
+ */
+
+#ifndef SIM_RARE_EVENT_H
+#define SIM_RARE_EVENT_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <stdexcept>
+
+#include "config.h"
+#include "arrivals.h"
+#include "random.h"
+#include "parallel.h"
+
+/// @brief Parameters of a rare-event run.
+struct RareEventOptions {
+    size_t cycles = 1000000;  // Twisted busy cycles; as many plain ones estimate the denominator
+    double twist = 0.0;       // lambda' / lambda; 0 selects mu^2 / lambda^2
+    unsigned threads = 1;
+    uint64_t seed = 1;
+    RandomEngine randomEngine = RandomEngine::XOSHIRO256PP;
+};
+
+/// @brief Drop probability estimate of one source, or of all of them.
+struct RareEventEstimate {
+    double dropProbability = 0.0;
+    double variance = 0.0;     // Of the estimator, by the delta method
+    double halfWidth = 0.0;    // Of the normal 95% confidence interval
+    double relativeError = 0.0;
+};
+
+/// @brief Outcome of FCFSRareEventEstimator::run().
+struct RareEventResult {
+    size_t cycles = 0;
+    double arrivalRate = 0.0;  // lambda, packets per second
+    double serviceRate = 0.0;  // mu at the mean packet size
+    double twistedRate = 0.0;  // lambda'
+    double arrivalsPerCycle = 0.0;
+    double cyclesWithDrops = 0.0; // Fraction of twisted cycles reaching a drop
+    RareEventEstimate all;
+    std::vector<RareEventEstimate> sources;
+};
+
+/// @brief Busy-cycle importance sampling for the FCFS tail-drop buffer.
+class FCFSRareEventEstimator {
+private:
+    // Blocks of cycles are seeded and reduced in a fixed order, so the
+    // result does not depend on the thread count
+    static const size_t kBlocks = 64;
+
+    struct InSystem {
+        double departure;
+        int size;
+    };
+
+    // Per-block sums of the cycle statistics
+    struct Tally {
+        double z = 0.0, zz = 0.0;      // Weighted drops per twisted cycle
+        double a = 0.0, aa = 0.0;      // Arrivals per plain cycle
+        double withDrops = 0.0;
+        std::vector<double> zs, zzs;   // Weighted drops per source
+    };
+
+    Config config;
+    double lambda = 0.0;
+    double mu = 0.0;
+    double byteLimit = 0.0;
+    std::vector<double> shares; // lambda_i / lambda
+    AliasTable picker;
+    std::vector<std::shared_ptr<const EmpiricalSizes>> tables; // Per source; null for uniform sizes
+
+    /**
+     * Simulates one busy cycle starting with an arrival to the empty system.
+     * Twisted cycles return the likelihood-weighted drops per source in
+     * `drops`; plain cycles only count arrivals.
+     */
+    template <class Random>
+    long cycle(Random& rng, std::vector<InSystem>& ring, double rate, std::vector<double>& drops) const {
+        const size_t capacity = ring.size();
+        size_t head = 0, count = 0;
+        double waitingBytes = 0.0; // Bytes buffered behind the packet in service
+        double lastDeparture = 0.0;
+        double t = 0.0;
+        double logRatio = 0.0;
+        bool twisted = rate != lambda;
+        long arrivals = 0;
+
+        for (;;) {
+            // Same draw order as ArrivalStream::take(): source, then size
+            int src = static_cast<int>(picker.sample(rng.uniform()));
+            const SourceConfig& sc = config.sources[src];
+            const EmpiricalSizes* empirical = tables[src].get();
+            int size = empirical ? empirical->sample(rng.uniform()) : rng.uniformInt(sc.minSize, sc.maxSize);
+            ++arrivals;
+
+            // Packets that left before this arrival
+            while (count > 0 && ring[head].departure <= t) {
+                if (++head == capacity) head = 0;
+                if (--count > 0) waitingBytes -= ring[head].size;
+            }
+            if (arrivals > 1 && count == 0) return arrivals - 1; // Regeneration: next cycle starts here
+
+            size_t waiting = count > 0 ? count - 1 : 0;
+            if (waiting < config.bufferSize && waitingBytes + size <= byteLimit) {
+                double startAt = count > 0 ? lastDeparture : t;
+                lastDeparture = startAt + size / config.linkCapacity;
+                size_t tail = head + count;
+                if (tail >= capacity) tail -= capacity;
+                ring[tail] = InSystem{lastDeparture, size};
+                if (count > 0) waitingBytes += size;
+                ++count;
+            } else {
+                drops[src] += std::exp(logRatio);
+                if (twisted) {
+                    twisted = false; // Overflow reached; the rest of the cycle is untwisted
+                    rate = lambda;
+                }
+            }
+            if (count == 0) return arrivals; // A lone, dropped packet
+
+            double gap = rng.exponential() / rate;
+            if (twisted) logRatio += std::log(lambda / rate) - (lambda - rate) * gap;
+            t += gap;
+        }
+    }
+
+public:
+    /**
+     * @brief Validates the scenario: every source must be active for the
+     * whole run, so that the superposed arrivals are one Poisson process.
+     */
+    void configure(const Config& scenario) {
+        config = scenario;
+        if (!poissonArrivals(config)) throw std::runtime_error("Rare-event mode needs Poisson sources");
+        lambda = 0.0;
+        double meanSize = 0.0;
+        std::vector<double> rates;
+        std::vector<std::shared_ptr<const EmpiricalSizes>> shared(config.sizeTables.size());
+        tables.clear();
+        for (size_t i = 0; i < config.sources.size(); ++i) {
+            const SourceConfig& sc = config.sources[i];
+            if (sc.startFraction != 0.0 || sc.endFraction != 1.0) {
+                throw std::runtime_error("Rare-event mode needs every source active for the whole run");
+            }
+            lambda += sc.packetRate;
+            meanSize += sc.packetRate * meanPacketSize(config, i);
+            rates.push_back(sc.packetRate);
+            int table = trafficModel(config, i).sizeTable;
+            if (table >= 0 && !shared[table]) shared[table] = std::make_shared<const EmpiricalSizes>(config.sizeTables[table]);
+            tables.push_back(table >= 0 ? shared[table] : nullptr);
+        }
+        if (lambda <= 0.0) throw std::runtime_error("Rare-event mode needs a positive arrival rate");
+        meanSize /= lambda;
+        mu = config.linkCapacity / meanSize;
+        byteLimit = bufferByteLimit(config);
+        shares.clear();
+        for (double r : rates) shares.push_back(r / lambda);
+        picker.build(rates);
+    }
+
+    RareEventResult run(const RareEventOptions& options) const {
+        RareEventResult result;
+        size_t numSources = config.sources.size();
+        double factor = options.twist > 0.0 ? options.twist : std::max(1.0, (mu * mu) / (lambda * lambda));
+        result.cycles = options.cycles;
+        result.arrivalRate = lambda;
+        result.serviceRate = mu;
+        result.twistedRate = lambda * factor;
+
+        std::vector<Tally> tallies(kBlocks);
+        parallelFor(kBlocks, options.threads, [&](size_t block, unsigned) {
+            RandomSource rng;
+            rng.setEngine(options.randomEngine);
+            rng.seed(options.seed * 0x9E3779B97F4A7C15ULL + block);
+            std::vector<InSystem> ring(bufferedPacketBound(config) + 1);
+            std::vector<double> drops(numSources);
+            Tally& tally = tallies[block];
+            tally.zs.assign(numSources, 0.0);
+            tally.zzs.assign(numSources, 0.0);
+
+            size_t n = options.cycles * (block + 1) / kBlocks - options.cycles * block / kBlocks;
+            for (size_t c = 0; c < n; ++c) {
+                drops.assign(numSources, 0.0);
+                cycle(rng, ring, result.twistedRate, drops);
+                double z = 0.0;
+                for (size_t i = 0; i < numSources; ++i) {
+                    z += drops[i];
+                    tally.zs[i] += drops[i];
+                    tally.zzs[i] += drops[i] * drops[i];
+                }
+                tally.z += z;
+                tally.zz += z * z;
+                if (z > 0.0) tally.withDrops += 1.0;
+
+                double a = static_cast<double>(cycle(rng, ring, lambda, drops));
+                tally.a += a;
+                tally.aa += a * a;
+            }
+        });
+
+        Tally sum;
+        sum.zs.assign(numSources, 0.0);
+        sum.zzs.assign(numSources, 0.0);
+        for (const Tally& t : tallies) {
+            sum.z += t.z;
+            sum.zz += t.zz;
+            sum.a += t.a;
+            sum.aa += t.aa;
+            sum.withDrops += t.withDrops;
+            for (size_t i = 0; i < numSources; ++i) {
+                sum.zs[i] += t.zs[i];
+                sum.zzs[i] += t.zzs[i];
+            }
+        }
+
+        double n = static_cast<double>(options.cycles);
+        double meanA = sum.a / n;
+        double varA = n > 1 ? (sum.aa - n * meanA * meanA) / (n - 1) : 0.0;
+        result.arrivalsPerCycle = meanA;
+        result.cyclesWithDrops = sum.withDrops / n;
+
+        // Ratio of independent means: Var(Zbar/Abar) ~ Var(Z)/(n Abar^2) + Zbar^2 Var(A)/(n Abar^4)
+        auto ratio = [&](double z, double zz, double share) {
+            RareEventEstimate e;
+            double meanZ = z / n;
+            double varZ = n > 1 ? (zz - n * meanZ * meanZ) / (n - 1) : 0.0;
+            double denominator = meanA * share;
+            if (denominator <= 0.0) return e;
+            e.dropProbability = meanZ / denominator;
+            e.variance = varZ / (n * denominator * denominator) +
+                         meanZ * meanZ * varA * share * share / (n * std::pow(denominator, 4));
+            e.halfWidth = 1.959964 * std::sqrt(e.variance);
+            e.relativeError = e.dropProbability > 0.0 ? std::sqrt(e.variance) / e.dropProbability : 0.0;
+            return e;
+        };
+        result.all = ratio(sum.z, sum.zz, 1.0);
+        for (size_t i = 0; i < numSources; ++i) result.sources.push_back(ratio(sum.zs[i], sum.zzs[i], shares[i]));
+        return result;
+    }
+};
+
+/**
+ * @brief Outputs a rare-event result in the printResults layout.
+ */
+inline void printRareEventResult(std::ostream& out, const RareEventResult& r) {
+    out << std::scientific << std::setprecision(6);
+    out << "## Rare-Event Drop Probability (FCFS, importance sampling over "
+        << r.cycles << " busy cycles)\n"
+        << "1. Drop Probability:     " << r.all.dropProbability << " +/- " << r.all.halfWidth << " (95% CI)\n"
+        << "2. Estimator Variance:   " << r.all.variance << "\n"
+        << "3. Relative Error:       " << r.all.relativeError << "\n"
+        << "4. Arrival Rate:         " << r.arrivalRate << " pkt/s (twisted to " << r.twistedRate
+        << ", service rate " << r.serviceRate << ")\n"
+        << "5. Arrivals per Cycle:   " << r.arrivalsPerCycle << "\n"
+        << "6. Cycles with Drops:    " << r.cyclesWithDrops << " (under the twisted rate)\n\n";
+
+    out << "## Per-Source Drop Probability\n"
+        << "----------------------------------------------------------------\n"
+        << "Src |  Drop Prob.  |   95% CI +/-  |   Variance   | Rel. Error\n"
+        << "----------------------------------------------------------------\n";
+    for (size_t i = 0; i < r.sources.size(); ++i) {
+        const RareEventEstimate& e = r.sources[i];
+        out << std::setw(3) << i << " | " << std::setw(12) << std::setprecision(4) << e.dropProbability
+            << " | " << std::setw(13) << e.halfWidth << " | " << std::setw(12) << e.variance
+            << " | " << std::setw(10) << std::setprecision(3) << e.relativeError << "\n";
+    }
+    out << "----------------------------------------------------------------\n" << std::fixed;
+}
+
+#endif // SIM_RARE_EVENT_H
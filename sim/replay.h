@@ -0,0 +1,372 @@
+/**
+ * @file replay.h
+ * @brief Trace-driven arrivals read from a memory-mapped capture.
+ * A replay input is a sequence of (timestamp, flow, size) arrivals in one of
+ * four formats, detected from the first bytes of the file:
+ *   - packet trace written by --trace (sim/trace.h); its ARRIVAL records are used
+ *   - binary arrival file: a TraceHeader with magic "PKTARRIV" followed by
+ *     16-byte ArrivalRecords
+ *   - classic libpcap capture (micro- or nanosecond, either byte order); the
+ *     flow is a hash of the IPv4/IPv6 addresses, protocol and ports
+ *   - CSV text: "timestamp,flow,size" per line; '#' comments and a non-numeric
+ *     header line are skipped
+ * The file is parsed incrementally from the mapping and consumed pages are
+ * released, so a trace of any size is replayed in constant memory.
+ * ReplayStream reorders arrivals through a bounded lookahead heap and
+ * rebases pcap timestamps, which are wall-clock, so the first arrival is at
+ * t = 0; the other formats keep their simulation times. Flow f arrives at
+ * source f % numSources. Sizes outside [1, INT_MAX] bytes are rejected.
+ */
+
+#ifndef SIM_REPLAY_H
+#define SIM_REPLAY_H
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <climits>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include "mapped_file.h"
+#include "trace.h"
+#include "arrivals.h"
+
+/// @brief One replayed arrival.
+struct ArrivalRecord {
+    double time;   // Seconds, in the trace's own time base
+    uint32_t flow;
+    uint32_t size; // Bytes
+};
+
+static_assert(sizeof(ArrivalRecord) == 16, "ArrivalRecord layout is part of the file format");
+
+static const char kArrivalMagic[8] = {'P', 'K', 'T', 'A', 'R', 'R', 'I', 'V'};
+static const uint32_t kArrivalVersion = 1;
+
+/// @brief Sequential parser over a mapped replay input, in file order.
+class ReplayTrace {
+public:
+    enum Format { PACKET_TRACE, BINARY, PCAP, CSV };
+
+private:
+    MappedFile file;
+    std::string path;
+    Format fileFormat = CSV;
+    size_t offset = 0;   // Next unread byte
+    size_t end = 0;      // Last byte the format may read
+    uint64_t line = 0;   // CSV line number, for error messages
+
+    // pcap framing
+    bool swapped = false;
+    double fractionScale = 1e-6;
+    uint32_t linkType = 1;
+
+    uint32_t read32(size_t at) const {
+        uint32_t v;
+        std::memcpy(&v, file.data() + at, sizeof(v));
+        return swapped ? __builtin_bswap32(v) : v;
+    }
+
+    static uint32_t mixFlow(uint64_t a, uint64_t b) {
+        uint64_t z = a * 0x9E3779B97F4A7C15ULL ^ (b + 0xBF58476D1CE4E5B9ULL + (a << 6) + (a >> 2));
+        z = (z ^ (z >> 31)) * 0x94D049BB133111EBULL;
+        return static_cast<uint32_t>(z ^ (z >> 32));
+    }
+
+    // Flow key of a captured frame: addresses, protocol and ports when the
+    // frame is IPv4/IPv6 (Ethernet, optionally VLAN-tagged, or raw IP); 0 otherwise
+    uint32_t flowOf(const unsigned char* frame, uint32_t captured) const {
+        const unsigned char* ip = frame;
+        uint32_t left = captured;
+        if (linkType == 1) {
+            if (left < 14) return 0;
+            uint32_t etherType = (frame[12] << 8) | frame[13];
+            uint32_t header = 14;
+            if (etherType == 0x8100 && left >= 18) {
+                etherType = (frame[16] << 8) | frame[17];
+                header = 18;
+            }
+            if (etherType != 0x0800 && etherType != 0x86DD) return 0;
+            ip += header;
+            left -= header;
+        } else if (linkType != 101 && linkType != 228 && linkType != 229) {
+            return 0;
+        }
+        if (left < 1) return 0;
+
+        uint64_t a = 0, b = 0;
+        uint32_t protocol = 0, transport = 0;
+        if ((ip[0] >> 4) == 4 && left >= 20) {
+            uint32_t src, dst;
+            std::memcpy(&src, ip + 12, 4);
+            std::memcpy(&dst, ip + 16, 4);
+            a = (static_cast<uint64_t>(src) << 32) | dst;
+            protocol = ip[9];
+            transport = (ip[0] & 0x0F) * 4;
+        } else if ((ip[0] >> 4) == 6 && left >= 40) {
+            uint64_t words[4];
+            std::memcpy(words, ip + 8, sizeof(words));
+            a = words[0] ^ (words[1] * 0xC2B2AE3D27D4EB4FULL);
+            b = words[2] ^ (words[3] * 0x165667B19E3779F9ULL);
+            protocol = ip[6];
+            transport = 40;
+        } else {
+            return 0;
+        }
+        b ^= static_cast<uint64_t>(protocol) << 56;
+        if ((protocol == 6 || protocol == 17) && left >= transport + 4) {
+            uint32_t ports;
+            std::memcpy(&ports, ip + transport, 4);
+            b ^= ports;
+        }
+        return mixFlow(a, b);
+    }
+
+    void fail(const std::string& what) const {
+        throw std::runtime_error(what + " in replay file " + path);
+    }
+
+    bool nextPacketTrace(ArrivalRecord& r) {
+        while (offset + sizeof(TraceRecord) <= end) {
+            TraceRecord t;
+            std::memcpy(&t, file.data() + offset, sizeof(t));
+            offset += sizeof(t);
+            if (t.type() != TraceRecord::ARRIVAL) continue;
+            r.time = t.time;
+            r.flow = t.sourceID;
+            r.size = t.size();
+            return true;
+        }
+        return false;
+    }
+
+    bool nextBinary(ArrivalRecord& r) {
+        if (offset + sizeof(ArrivalRecord) > end) return false;
+        std::memcpy(&r, file.data() + offset, sizeof(r));
+        if (r.size < 1 || r.size > INT_MAX) fail("Packet size out of range at byte " + std::to_string(offset));
+        offset += sizeof(r);
+        return true;
+    }
+
+    bool nextPcap(ArrivalRecord& r) {
+        if (offset + 16 > end) return false;
+        uint32_t seconds = read32(offset);
+        uint32_t fraction = read32(offset + 4);
+        uint32_t captured = read32(offset + 8);
+        uint32_t original = read32(offset + 12);
+        offset += 16;
+        if (captured > end - offset) fail("Truncated pcap record");
+        if (original < 1 || original > INT_MAX) fail("Packet size out of range at byte " + std::to_string(offset - 16));
+
+        r.time = seconds + fraction * fractionScale;
+        r.flow = flowOf(reinterpret_cast<const unsigned char*>(file.data() + offset), captured);
+        r.size = original;
+        offset += captured;
+        return true;
+    }
+
+    bool nextCsv(ArrivalRecord& r) {
+        const char* base = file.data();
+        char buffer[256];
+        while (offset < end) {
+            const char* start = base + offset;
+            const char* stop = static_cast<const char*>(std::memchr(start, '\n', end - offset));
+            size_t length = stop ? static_cast<size_t>(stop - start) : end - offset;
+            offset += length + (stop ? 1 : 0);
+            ++line;
+
+            // strtod needs a terminated string and the mapping is not one
+            if (length >= sizeof(buffer)) fail("Line " + std::to_string(line) + " is too long");
+            std::memcpy(buffer, start, length);
+            buffer[length] = '\0';
+
+            const char* p = buffer;
+            while (*p == ' ' || *p == '\t') ++p;
+            if (*p == '\0' || *p == '\r' || *p == '#') continue;
+            bool numeric = (*p >= '0' && *p <= '9') || *p == '.' || *p == '-' || *p == '+';
+            if (!numeric) {
+                if (line == 1) continue; // Column header
+                fail("Malformed line " + std::to_string(line));
+            }
+
+            char* next = nullptr;
+            r.time = std::strtod(p, &next);
+            if (*next != ',') fail("Malformed line " + std::to_string(line));
+            unsigned long flow = std::strtoul(next + 1, &next, 10);
+            if (*next != ',') fail("Malformed line " + std::to_string(line));
+            const char* sizeField = next + 1;
+            errno = 0;
+            long long size = std::strtoll(sizeField, &next, 10);
+            if (next == sizeField) fail("Malformed line " + std::to_string(line));
+            if (errno == ERANGE || size < 1 || size > INT_MAX) {
+                fail("Packet size out of range [1, " + std::to_string(INT_MAX) + "] on line " + std::to_string(line));
+            }
+            while (*next == ' ' || *next == '\t' || *next == '\r') ++next;
+            if (*next != '\0') fail("Malformed line " + std::to_string(line));
+
+            r.flow = static_cast<uint32_t>(flow);
+            r.size = static_cast<uint32_t>(size);
+            return true;
+        }
+        return false;
+    }
+
+public:
+    void open(const std::string& filename) {
+        path = filename;
+        file.open(filename);
+        offset = 0;
+        end = file.size();
+        line = 0;
+        const char* d = file.data();
+
+        uint32_t magic = 0;
+        if (end >= 4) std::memcpy(&magic, d, 4);
+
+        if (end >= sizeof(TraceHeader) && std::memcmp(d, kTraceMagic, sizeof(kTraceMagic)) == 0) {
+            TraceHeader h;
+            std::memcpy(&h, d, sizeof(h));
+            if (h.version != kTraceVersion || h.recordSize != sizeof(TraceRecord)) fail("Unsupported packet trace");
+            fileFormat = PACKET_TRACE;
+            offset = sizeof(TraceHeader);
+            end = offset + std::min<uint64_t>(h.recordCount, (end - offset) / sizeof(TraceRecord)) * sizeof(TraceRecord);
+        } else if (end >= sizeof(TraceHeader) && std::memcmp(d, kArrivalMagic, sizeof(kArrivalMagic)) == 0) {
+            TraceHeader h;
+            std::memcpy(&h, d, sizeof(h));
+            if (h.version != kArrivalVersion || h.recordSize != sizeof(ArrivalRecord)) fail("Unsupported arrival file");
+            fileFormat = BINARY;
+            offset = sizeof(TraceHeader);
+            end = offset + std::min<uint64_t>(h.recordCount, (end - offset) / sizeof(ArrivalRecord)) * sizeof(ArrivalRecord);
+        } else if (end >= 24 && (magic == 0xA1B2C3D4u || magic == 0xD4C3B2A1u ||
+                                 magic == 0xA1B23C4Du || magic == 0x4D3CB2A1u)) {
+            fileFormat = PCAP;
+            swapped = (magic == 0xD4C3B2A1u || magic == 0x4D3CB2A1u);
+            fractionScale = (magic == 0xA1B23C4Du || magic == 0x4D3CB2A1u) ? 1e-9 : 1e-6;
+            linkType = read32(20) & 0x0FFFFFFF;
+            offset = 24;
+        } else {
+            fileFormat = CSV;
+        }
+    }
+
+    Format format() const { return fileFormat; }
+
+    /// @brief Reads the next arrival in file order; false at the end.
+    bool next(ArrivalRecord& r) {
+        bool more = false;
+        switch (fileFormat) {
+            case PACKET_TRACE: more = nextPacketTrace(r); break;
+            case BINARY: more = nextBinary(r); break;
+            case PCAP: more = nextPcap(r); break;
+            case CSV: more = nextCsv(r); break;
+        }
+        file.releaseBefore(offset);
+        return more;
+    }
+};
+
+/**
+ * @brief Time-ordered arrivals from a ReplayTrace through a bounded
+ * reorder window. Up to `lookahead` parsed arrivals are heaped by time, so
+ * captures that are only locally out of order replay sorted. An arrival
+ * that is still earlier than one already released is clamped to that time
+ * and counted in reordered().
+ */
+class ReplayStream {
+private:
+    ReplayTrace trace;
+    std::vector<ArrivalRecord> window; // Min-heap on time
+    size_t lookahead = 4096;
+    bool exhausted = false;
+    bool rebased = false;
+    double origin = 0.0;
+    double lastTime = 0.0;
+    uint64_t clamped = 0;
+    uint64_t released = 0;
+
+    static bool later(const ArrivalRecord& a, const ArrivalRecord& b) { return a.time > b.time; }
+
+    void fill() {
+        ArrivalRecord r;
+        while (!exhausted && window.size() < lookahead) {
+            if (!trace.next(r)) {
+                exhausted = true;
+                break;
+            }
+            window.push_back(r);
+            std::push_heap(window.begin(), window.end(), later);
+        }
+    }
+
+public:
+    /**
+     * @brief Opens `path`; `window` is the reorder lookahead in arrivals.
+     */
+    void open(const std::string& path, size_t windowSize = 4096) {
+        trace.open(path);
+        lookahead = std::max<size_t>(1, windowSize);
+        window.clear();
+        window.reserve(lookahead);
+        exhausted = false;
+        rebased = trace.format() != ReplayTrace::PCAP;
+        origin = lastTime = 0.0;
+        clamped = released = 0;
+    }
+
+    ReplayTrace::Format format() const { return trace.format(); }
+
+    /**
+     * @brief Next arrival in time order; false once the trace is exhausted.
+     */
+    bool next(ArrivalRecord& r) {
+        fill();
+        if (window.empty()) return false;
+        std::pop_heap(window.begin(), window.end(), later);
+        r = window.back();
+        window.pop_back();
+
+        if (!rebased) {
+            origin = r.time;
+            rebased = true;
+        }
+        r.time -= origin;
+        if (r.time < lastTime) {
+            r.time = lastTime;
+            ++clamped;
+        }
+        lastTime = r.time;
+        ++released;
+        return true;
+    }
+
+    uint64_t arrivals() const { return released; }
+    uint64_t reordered() const { return clamped; }
+};
+
+/// @brief Arrival lane (see arrivals.h) over a ReplayStream; flow f feeds source f % numSources.
+class ReplayGenerator {
+private:
+    ReplayStream* stream = nullptr;
+    uint32_t numSources = 1;
+    ArrivalRecord pending = ArrivalRecord();
+
+public:
+    ReplayGenerator() = default;
+    ReplayGenerator(ReplayStream* s, int sources) : stream(s), numSources(static_cast<uint32_t>(sources)) {}
+
+    bool start() { return numSources > 0 && stream->next(pending); }
+    double headTime() const { return pending.time; }
+
+    template <class Random>
+    bool take(Random&, Arrival& out) {
+        out.source = static_cast<int>(pending.flow % numSources);
+        out.size = static_cast<int>(pending.size);
+        return stream->next(pending);
+    }
+};
+
+#endif // SIM_REPLAY_H
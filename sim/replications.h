@@ -0,0 +1,265 @@
+/**
+ * @file replications.h
+ * @brief Independent replications of one scenario, run in parallel.
+ * Each replication gets its own Simulator instance and seed, and the
+ * printResults metrics are reduced to a mean and a Student-t confidence
+ * interval across replications. Optionally the means are adjusted with the
+ * arrival count as a control variate: its expectation is known in closed
+ * form from the source rates, and runs that drew more traffic than
+ * expected see more delay and loss, so regressing on it removes part of
+ * the run-to-run noise.
+ */
+
+#ifndef SIM_REPLICATIONS_H
+#define SIM_REPLICATIONS_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <cstdint>
+#include <string>
+#include <functional>
+#include <set>
+#include <utility>
+
+#include "simulator.h"
+#include "steady_state.h"
+#include "parallel.h"
+
+/// @brief Per-source estimates across replications.
+struct SourceSummary {
+    double weight = 0.0;
+    Estimate dropRate;
+    Estimate avgDelay;
+    Estimate throughput;
+};
+
+/// @brief Cross-replication summary of the printResults metrics.
+struct ReplicationSummary {
+    size_t replications = 0;
+    Estimate utilization;
+    Estimate avgDelay;
+    Estimate dropProbability;
+    Estimate fairness;
+    Estimate delayP50;
+    Estimate delayP99;
+    Estimate delayP999;
+    bool controlled = false; // Means adjusted with the arrival-count control variate
+    std::vector<SourceSummary> sources;
+};
+
+/**
+ * @brief Observer of finished runs: called with the run's index and metrics
+ * as soon as it completes, on the worker thread that ran it, so it must be
+ * safe to call concurrently.
+ */
+typedef std::function<void(size_t, const Metrics&)> RunCallback;
+
+/**
+ * @brief Control variate of one run: packets generated minus the count the
+ * sources predict over the run's measured interval. Every arrival stream
+ * admits one packet at its start time and Poisson arrivals after it, so the
+ * prediction is lambda t plus one for each stream starting inside the
+ * interval. `aggregate` says whether streams were merged by activity window
+ * (RunOptions::aggregateArrivals). The mean is zero, also with warm-up
+ * detection and early stopping, because N(t) - lambda t is a martingale and
+ * those intervals end at stopping times.
+ */
+inline double arrivalSurplus(const Metrics& m, const Config& config, bool aggregate) {
+    double expected = 0.0;
+    if (!poissonArrivals(config)) {
+        throw std::runtime_error("The arrival-count control variate needs Poisson sources");
+    }
+    std::set<std::pair<double, double>> windows;
+    for (const auto& sc : config.sources) {
+        double start = sc.startFraction * config.simulationTime;
+        double from = std::max(m.measureStart, start);
+        double to = std::min(m.measureEnd, sc.endFraction * config.simulationTime);
+        if (to > from) expected += sc.packetRate * (to - from);
+        bool first = !aggregate || windows.insert(std::make_pair(sc.startFraction, sc.endFraction)).second;
+        if (first && start >= m.measureStart && start < m.measureEnd) expected += 1.0;
+    }
+    double generated = 0.0;
+    for (const auto& src : m.sources) generated += src.packetsGenerated;
+    return generated - expected;
+}
+
+/**
+ * @brief Control-variate estimate of E[y] from pairs (y_r, c_r) with
+ * E[c] = 0: ybar - beta cbar, with beta fitted by least squares and the
+ * interval from the regression residuals on n - 2 degrees of freedom.
+ */
+inline Estimate controlledEstimate(const std::vector<double>& y, const std::vector<double>& c) {
+    size_t n = y.size();
+    if (n < 3) return estimate(y);
+    double my = 0.0, mc = 0.0;
+    for (size_t r = 0; r < n; ++r) {
+        my += y[r];
+        mc += c[r];
+    }
+    my /= n;
+    mc /= n;
+    double scc = 0.0, scy = 0.0;
+    for (size_t r = 0; r < n; ++r) {
+        scc += (c[r] - mc) * (c[r] - mc);
+        scy += (c[r] - mc) * (y[r] - my);
+    }
+    if (scc <= 0.0) return estimate(y);
+    double beta = scy / scc;
+    double residual = 0.0;
+    for (size_t r = 0; r < n; ++r) {
+        double e = (y[r] - my) - beta * (c[r] - mc);
+        residual += e * e;
+    }
+    Estimate e;
+    e.mean = my - beta * mc;
+    double variance = residual / (n - 2) * (1.0 / n + mc * mc / scc);
+    e.halfWidth = studentT975(n - 2) * std::sqrt(variance);
+    return e;
+}
+
+/**
+ * @brief Reduces the runs to means and intervals, adjusting every metric
+ * with `controls` (one arrivalSurplus() per run) when given.
+ */
+inline ReplicationSummary summarize(const std::vector<Metrics>& runs,
+                                    const std::vector<double>* controls = nullptr) {
+    ReplicationSummary s;
+    s.replications = runs.size();
+    s.controlled = controls != nullptr;
+    if (runs.empty()) return s;
+
+    std::vector<double> column(runs.size());
+    auto reduceColumn = [&]() {
+        return controls ? controlledEstimate(column, *controls) : estimate(column);
+    };
+    auto reduce = [&](double (*get)(const Metrics&)) {
+        for (size_t r = 0; r < runs.size(); ++r) column[r] = get(runs[r]);
+        return reduceColumn();
+    };
+    s.utilization = reduce([](const Metrics& m) { return m.utilization; });
+    s.avgDelay = reduce([](const Metrics& m) { return m.avgDelay; });
+    s.dropProbability = reduce([](const Metrics& m) { return m.dropProbability; });
+    s.fairness = reduce([](const Metrics& m) { return m.fairness; });
+    s.delayP50 = reduce([](const Metrics& m) { return m.delayP50; });
+    s.delayP99 = reduce([](const Metrics& m) { return m.delayP99; });
+    s.delayP999 = reduce([](const Metrics& m) { return m.delayP999; });
+
+    size_t numSources = runs[0].sources.size();
+    for (size_t i = 0; i < numSources; ++i) {
+        SourceSummary src;
+        src.weight = runs[0].sources[i].weight;
+        for (size_t r = 0; r < runs.size(); ++r) column[r] = runs[r].sources[i].dropRate;
+        src.dropRate = reduceColumn();
+        for (size_t r = 0; r < runs.size(); ++r) column[r] = runs[r].sources[i].avgDelay;
+        src.avgDelay = reduceColumn();
+        for (size_t r = 0; r < runs.size(); ++r) column[r] = runs[r].sources[i].throughput;
+        src.throughput = reduceColumn();
+        s.sources.push_back(src);
+    }
+    return s;
+}
+
+/**
+ * @brief Runs `replications` independent copies of a scenario on `threads`
+ * workers. Replication r is seeded from (baseSeed, r) so results do not
+ * depend on the thread count or scheduling order; `onRun`, if set, sees
+ * each replication as it finishes.
+ */
+template <class Sim>
+std::vector<Metrics> runReplications(const Config& config, size_t replications, unsigned threads,
+                                     uint64_t baseSeed, const RunOptions& options,
+                                     const RunCallback& onRun = nullptr) {
+    std::vector<Metrics> results(replications);
+    std::vector<Sim> simulators(std::max(1u, threads));
+
+    parallelFor(replications, threads, [&](size_t r, unsigned worker) {
+        Sim& sim = simulators[worker];
+        sim.configure(config);
+        sim.setRunOptions(options);
+        sim.seed(baseSeed * 0x9E3779B97F4A7C15ULL + r);
+        sim.run();
+        results[r] = sim.metrics();
+        if (onRun) onRun(r, results[r]);
+    });
+    return results;
+}
+
+/**
+ * @brief Continues `replications` copies of a checkpointed run, each
+ * reseeded from (baseSeed, r) after the restore so the copies branch from
+ * the shared history into independent futures.
+ */
+template <class Sim>
+std::vector<Metrics> runReplicationsFrom(const std::string& snapshot, size_t replications, unsigned threads,
+                                         uint64_t baseSeed, const RunCallback& onRun = nullptr) {
+    std::vector<Metrics> results(replications);
+    std::vector<Sim> simulators(std::max(1u, threads));
+
+    parallelFor(replications, threads, [&](size_t r, unsigned worker) {
+        Sim& sim = simulators[worker];
+        sim.restore(snapshot);
+        sim.seed(baseSeed * 0x9E3779B97F4A7C15ULL + r);
+        sim.resume();
+        results[r] = sim.metrics();
+        if (onRun) onRun(r, results[r]);
+    });
+    return results;
+}
+
+/// @brief Writes a half-width in a field of `width`, or "n/a" when it is undefined.
+inline void putHalfWidth(std::ostream& out, double halfWidth, int width = 0) {
+    out << std::setw(width);
+    if (std::isfinite(halfWidth)) {
+        out << halfWidth;
+    } else {
+        out << "n/a";
+    }
+}
+
+/**
+ * @brief Outputs the cross-replication summary in the printResults layout.
+ * Half-widths of a single replication are printed as n/a.
+ */
+inline void printReplicationSummary(std::ostream& out, const char* discipline,
+                                    const ReplicationSummary& s) {
+    out << std::fixed << std::setprecision(6);
+    out << "## System-Level Performance Metrics (" << discipline << ", "
+        << s.replications << " replications, mean +/- 95% CI"
+        << (s.controlled ? ", arrival-count control variate" : "") << ")\n";
+    static const char* labels[] = {"1. Server Utilization:   ", "2. Avg. Packet Delay:    ",
+                                   "3. Packet Drop Prob.:    ", "4. Fairness Index:       ",
+                                   "5. Delay p50:            ", "6. Delay p99:            ",
+                                   "7. Delay p99.9:          "};
+    static const char* units[] = {"", " s", "", "", " s", " s", " s"};
+    const Estimate* values[] = {&s.utilization, &s.avgDelay, &s.dropProbability, &s.fairness,
+                                &s.delayP50, &s.delayP99, &s.delayP999};
+    for (size_t m = 0; m < sizeof(values) / sizeof(values[0]); ++m) {
+        out << labels[m] << values[m]->mean << " +/- ";
+        putHalfWidth(out, values[m]->halfWidth);
+        out << units[m] << "\n";
+    }
+    out << "\n";
+
+    out << "## Per-Source Statistics (mean +/- 95% CI)\n"
+        << "-----------------------------------------------------------------------------------------------\n"
+        << "Src | Weight |      Drop Rate      |     Avg Delay (s)     |        Thruput (B/s)\n"
+        << "-----------------------------------------------------------------------------------------------\n";
+    for (size_t i = 0; i < s.sources.size(); ++i) {
+        const SourceSummary& src = s.sources[i];
+        out << std::setw(3) << i << " | "
+            << std::setw(6) << std::setprecision(2) << src.weight << " | "
+            << std::setw(8) << std::setprecision(4) << src.dropRate.mean << " +/- ";
+        putHalfWidth(out, src.dropRate.halfWidth, 6);
+        out << " | " << std::setw(9) << std::setprecision(6) << src.avgDelay.mean << " +/- ";
+        putHalfWidth(out, src.avgDelay.halfWidth, 8);
+        out << " | " << std::setw(11) << std::setprecision(2) << src.throughput.mean << " +/- ";
+        putHalfWidth(out, src.throughput.halfWidth, 8);
+        out << "\n";
+    }
+    out << "-----------------------------------------------------------------------------------------------\n";
+}
+
+#endif // SIM_REPLICATIONS_H
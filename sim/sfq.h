@@ -0,0 +1,103 @@
+/**
+ * @file sfq.h
+ * @brief Start-time Fair Queuing (SFQ) scheduling discipline (Goyal, Vin & Cheng, 1996).
+ * Packets are tagged with a virtual start time S = max(v, F_prev) and finish
+ * time F = S + size / weight, and served in increasing start-tag order. The
+ * system virtual time v is simply the start tag of the packet last sent, so
+ * unlike WFQ there is no GPS emulation. An arrival to an empty buffer
+ * starts from the largest finish tag served, which is the paper's
+ * end-of-busy-period rule up to the packet still on the link.
+ * TaggedFlowBuffer orders on Packet::virtualFinishTime, so that field holds
+ * the start tag here.
+ * A source of weight 0 is tagged as the lightest weighted source.
+ * Drop Policy: Tail-drop on the shared buffer, by packet count and bytes;
+ * dropped packets take no tags.
+ */
+
+#ifndef SIM_SFQ_H
+#define SIM_SFQ_H
+
+#include <vector>
+#include <algorithm>
+
+#include "simulator.h"
+#include "flow_buffer.h"
+
+/// @brief Start-tag-ordered buffer plus the per-source SFQ state.
+class SFQDiscipline {
+private:
+    size_t bufferSize = 0;
+    double byteLimit = 0.0;
+    double virtualTime = 0.0;
+    double maxFinishServed = 0.0;
+    std::vector<double> weights;
+    std::vector<double> lastFinishTime; // F of each source's latest admitted packet
+    PacketPool* pool = nullptr;
+
+    TaggedFlowBuffer packetBuffer;
+
+public:
+    static const char* name() { return "SFQ"; }
+    static const bool weightedFairness = true;
+
+    void configure(const Config& config, PacketPool& packetPool) {
+        pool = &packetPool;
+        bufferSize = config.bufferSize;
+        byteLimit = bufferByteLimit(config);
+        virtualTime = maxFinishServed = 0.0;
+        // Sources without a positive weight are treated as the lightest, as
+        // in DRR, so every tag stays finite
+        double minWeight = 0.0;
+        for (const auto& sc : config.sources) {
+            if (sc.weight > 0 && (minWeight == 0.0 || sc.weight < minWeight)) minWeight = sc.weight;
+        }
+        weights.clear();
+        for (const auto& sc : config.sources) {
+            weights.push_back(sc.weight > 0 ? sc.weight : (minWeight > 0 ? minWeight : 1.0));
+        }
+        lastFinishTime.assign(config.sources.size(), 0.0);
+        packetBuffer.reset(config.sources.size(), packetPool);
+    }
+
+    bool empty() const { return packetBuffer.empty(); }
+    size_t size() const { return packetBuffer.size(); }
+
+    template <class OnDrop>
+    void enqueue(PacketHandle h, OnDrop onDrop) {
+        Packet& p = (*pool)[h];
+        if (packetBuffer.size() >= bufferSize || packetBuffer.byteCount() + p.size > byteLimit) {
+            onDrop(h);
+            return;
+        }
+        if (packetBuffer.empty()) virtualTime = std::max(virtualTime, maxFinishServed);
+
+        double startTag = std::max(virtualTime, lastFinishTime[p.sourceID]);
+        lastFinishTime[p.sourceID] = startTag + p.size / weights[p.sourceID];
+        p.virtualFinishTime = startTag;
+        packetBuffer.push(h);
+    }
+
+    PacketHandle dequeue() {
+        PacketHandle h = packetBuffer.pop();
+        const Packet& p = (*pool)[h];
+        virtualTime = p.virtualFinishTime;
+        maxFinishServed = std::max(maxFinishServed, p.virtualFinishTime + p.size / weights[p.sourceID]);
+        return h;
+    }
+
+    void saveState(StateWriter& out) const {
+        out.put(virtualTime, maxFinishServed);
+        out.putVector(lastFinishTime);
+        packetBuffer.saveState(out);
+    }
+
+    void loadState(StateReader& in) {
+        in.get(virtualTime, maxFinishServed);
+        in.getVector(lastFinishTime, weights.size());
+        packetBuffer.loadState(in);
+    }
+};
+
+typedef Simulator<SFQDiscipline> SFQSimulator;
+
+#endif // SIM_SFQ_H
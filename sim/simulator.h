@@ -0,0 +1,724 @@
+/**
+ * @file simulator.h
+ * @brief Discrete-event engine shared by all packet scheduling disciplines.
+ * Simulates a single network link with a finite buffer shared by multiple
+ * traffic sources. The buffering and service order are supplied by a
+ * Discipline policy class so that the enqueue/dequeue hot path is resolved at
+ * compile time. The future event list is a second policy (see event_queue.h)
+ * and defaults to a binary heap.
+ *
+ * Packets live in a PacketPool owned by the engine; disciplines buffer
+ * handles into it. An optional AQM stage (aqm.h) can drop packets early,
+ * either before they reach the discipline or as it hands them to the link.
+ * A Discipline must provide:
+ *   static const char* name();                       // Label used in reports
+ *   static const bool weightedFairness;              // Normalize fairness by weight
+ *   void configure(const Config&, PacketPool&);
+ *   bool empty() const;
+ *   size_t size() const;
+ *   template <class OnDrop>
+ *   void enqueue(PacketHandle h, OnDrop onDrop);     // May call onDrop(PacketHandle)
+ *   PacketHandle dequeue();                          // Next packet to transmit
+ *   void saveState(StateWriter&) const;              // Buffered packets and tags, for checkpoints
+ *   void loadState(StateReader&);                    // After configure() with the same Config
+ *
+ * run() is start() followed by advance(simulationTime). A run paused by
+ * advance() can be snapshotted with checkpoint() and continued, in this or
+ * another process, by restore() and resume(); the continuation reproduces
+ * the uninterrupted run exactly.
+ *
+ * Statistics can skip a warm-up (RunOptions::warmup, or autoWarmup for
+ * MSER-5 detection, see steady_state.h) and the run can end early once the
+ * mean delay is known to RunOptions::precision; rates are then taken over
+ * the measured interval only.
+ *
+ * Built with -DSIM_INSTRUMENT, the engine also counts and times its handlers
+ * (instrument.h) and printResults() appends the counters.
+ */
+
+#ifndef SIM_SIMULATOR_H
+#define SIM_SIMULATOR_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <iomanip>
+#include <cstdint>
+#include <stdexcept>
+
+#include "config.h"
+#include "event_queue.h"
+#include "arrivals.h"
+#include "packet_pool.h"
+#include "random.h"
+#include "histogram.h"
+#include "source_stats.h"
+#include "aqm.h"
+#include "trace.h"
+#include "replay.h"
+#include "checkpoint.h"
+#include "steady_state.h"
+#include "instrument.h"
+#ifndef SIM_NO_TIMESERIES
+#include "timeseries.h"
+#endif
+
+/// @brief Traffic source configuration.
+struct Source {
+    int id;
+    double packetRate;
+    int minSize;
+    int maxSize;
+    double weight;
+    double startTime;
+    double endTime;
+    TrafficModel traffic;
+    std::shared_ptr<const EmpiricalSizes> sizeTable; // Null for uniform sizes
+
+    Source(int id, double rate, int min, int max, double w, double start, double end)
+        : id(id), packetRate(rate), minSize(min), maxSize(max), weight(w),
+          startTime(start), endTime(end) {}
+};
+
+/// @brief Derived per-source figures reported by printResults.
+struct SourceMetrics {
+    double weight;
+    long packetsGenerated;
+    long packetsTransmitted;
+    long packetsDropped;
+    double dropRate;
+    double avgDelay;   // Seconds
+    double delayP50;   // Seconds
+    double delayP99;
+    double delayP999;
+    double throughput; // Bytes per second
+};
+
+/// @brief System-level and per-source results of one simulation run.
+struct Metrics {
+    double utilization = 0.0;
+    double avgDelay = 0.0;
+    double dropProbability = 0.0;
+    double fairness = 0.0;
+    double delayP50 = 0.0;
+    double delayP99 = 0.0;
+    double delayP999 = 0.0;
+    double measureStart = 0.0; // Interval the statistics cover, in seconds
+    double measureEnd = 0.0;
+    std::vector<SourceMetrics> sources;
+};
+
+/// @brief Run-time switches applied to a Simulator before run().
+struct RunOptions {
+    bool aggregateArrivals = false; // One superposed Poisson stream per activity window
+    RandomEngine randomEngine = RandomEngine::XOSHIRO256PP;
+    double metricsWindow = 0.0;     // Seconds per time-series sample; 0 disables
+    size_t metricsCapacity = 4096;  // Windows retained by the time series
+    AQMConfig aqm;                  // Early-drop stage; AQMPolicy::NONE disables it
+    double warmup = 0.0;            // Seconds discarded before statistics accumulate
+    bool autoWarmup = false;        // Detect the warm-up end with MSER-5 instead
+    double precision = 0.0;         // Stop once the mean delay's 95% CI is within this fraction; 0 disables
+};
+
+/// @brief Encapsulates the simulation engine and state for one discipline.
+template <class Discipline, class EventQueue = BinaryHeapQueue>
+class Simulator {
+private:
+    int numSources = 0;
+    double simulationTime = 0.0;
+    double linkCapacity = 0.0;
+
+    double currentTime = 0.0;
+    bool linkBusy = false;
+    long nextPacketId = 1;
+    uint64_t eventsProcessed = 0;
+    double queuedBytes = 0.0; // Bytes held by the discipline
+    RunOptions options;
+    bool holding = false; // `held` was popped beyond the advance() horizon
+    Event held;
+    double measureStart = 0.0; // Warm-up end; statistics cover [measureStart, measureEnd]
+    double measureEnd = 0.0;
+    double warmupCut = -1.0;   // MSER-5 truncation point; negative until detected
+    bool stopped = false;      // Ended early on the precision target
+    SteadyStateMonitor monitor;
+    EngineCounters counters; // Empty unless built with SIM_INSTRUMENT; not checkpointed
+
+    Config scenario; // As configured; embedded in checkpoints
+    std::vector<Source> sources;
+    std::vector<ArrivalStream> arrivalStreams;
+    SourceStatsTable stats;
+    SourceStatsTable::Array<double> weights; // Per source, contiguous for the fairness reduction
+    PacketPool pool;
+    Discipline packetBuffer;
+    EventQueue eventQueue;
+    RandomSource rng;
+    AQMStage aqmStage;
+    TraceWriter* trace = nullptr; // Optional per-packet trace sink
+    ReplayStream* replay = nullptr; // Replaces the synthetic sources when set
+    ReplayGenerator replayLane;
+#ifndef SIM_NO_TIMESERIES
+    TimeSeries series;
+#endif
+    // The runners keep one simulator per worker side by side; this keeps the
+    // hot scalars at the start of one off the last line of the previous one
+    char padTail[kCacheLineSize];
+
+    void scheduleEvent(const Event& e) {
+        if (e.time <= simulationTime) {
+            eventQueue.push(e);
+            counters.queueDepth(eventQueue.size());
+        }
+    }
+
+    void dropPacket(PacketHandle h) {
+        stats.packetsDropped[pool[h].sourceID]++;
+        if (trace) trace->record(TraceRecord::DROP, currentTime, pool[h]);
+        pool.release(h);
+    }
+
+    void startNextTransmission() {
+        EngineCounters::Scope scope(counters, Handler::TRANSMISSION);
+        if (linkBusy) return;
+
+        while (!packetBuffer.empty()) {
+            PacketHandle packetToTransmit = packetBuffer.dequeue();
+            const Packet& p = pool[packetToTransmit];
+            queuedBytes -= p.size;
+            if (aqmStage.atDequeue() &&
+                aqmStage.shouldDrop(currentTime, currentTime - p.arrivalTime, packetBuffer.size(), queuedBytes, rng)) {
+                counters.drop(DropPath::AQM_DEQUEUE);
+                dropPacket(packetToTransmit);
+                continue;
+            }
+
+            linkBusy = true;
+            double transmissionTime = p.size / linkCapacity;
+            scheduleEvent(Event(Event::PACKET_DEPARTURE, currentTime + transmissionTime, packetToTransmit));
+            return;
+        }
+    }
+
+    // Creates a packet arriving now and hands it to the discipline
+    void admitPacket(int srcID, int size) {
+        PacketHandle h = pool.allocate();
+        pool[h] = Packet{nextPacketId++, srcID, size, currentTime, 0.0};
+        stats.packetsGenerated[srcID]++;
+        if (trace) trace->record(TraceRecord::ARRIVAL, currentTime, pool[h]);
+
+        if (aqmStage.atEnqueue() &&
+            aqmStage.shouldDrop(currentTime, queuedBytes / linkCapacity, packetBuffer.size(), queuedBytes, rng)) {
+            counters.drop(DropPath::AQM_ENQUEUE);
+            dropPacket(h);
+            return;
+        }
+
+        // Buffer management is otherwise up to the discipline
+        queuedBytes += size;
+        packetBuffer.enqueue(h, [this](PacketHandle dropped) {
+            queuedBytes -= pool[dropped].size;
+            counters.drop(DropPath::BUFFER);
+            dropPacket(dropped);
+        });
+        counters.bufferDepth(packetBuffer.size());
+
+        startNextTransmission();
+    }
+
+    // Takes a lane's pending arrival and schedules the lane's next one, so
+    // each lane has at most one event in the queue
+    template <class Lane>
+    void serveLane(Lane& lane, Event::Type type, uint32_t index) {
+        Arrival a;
+        if (lane.take(rng, a)) scheduleEvent(Event(type, lane.headTime(), index));
+        admitPacket(a.source, a.size);
+    }
+
+    template <class Lane>
+    void startLane(Lane& lane, Event::Type type, uint32_t index) {
+        if (lane.start()) scheduleEvent(Event(type, lane.headTime(), index));
+    }
+
+    void handleDepartureEvent(const Event& e) {
+        linkBusy = false;
+        const Packet& p = pool[e.index];
+        stats.recordDeparture(p.sourceID, p.size, currentTime - p.arrivalTime);
+        if (monitor.enabled()) monitor.observe(currentTime, currentTime - p.arrivalTime);
+        if (trace) trace->record(TraceRecord::DEPARTURE, currentTime, p);
+        pool.release(e.index);
+
+        startNextTransmission();
+    }
+
+#ifndef SIM_NO_TIMESERIES
+    void handleSampleEvent(const Event& e) {
+        series.sample(currentTime, packetBuffer.size(), linkCapacity,
+                      [this](size_t i) { return stats.bytesTransmitted[i]; });
+        scheduleEvent(Event(Event::METRICS_SAMPLE, series.sampleTime(e.index + 1), e.index + 1));
+    }
+#endif
+
+    // Run-control checks are spread evenly over the run
+    static const int kRunChecks = 1000;
+    double checkTime(uint32_t k) const { return k * (simulationTime / kRunChecks); }
+
+    // Restarts the statistics at the end of the warm-up
+    void beginMeasurement() {
+        monitor.endWarmup();
+#ifndef SIM_NO_TIMESERIES
+        series.rebase([this](size_t i) { return stats.bytesTransmitted[i]; });
+#endif
+        stats.reset(numSources);
+        measureStart = currentTime;
+    }
+
+    // Returns false when the run has met its precision target
+    bool handleRunControl(const Event& e) {
+        if (e.index == 0) {
+            beginMeasurement();
+            return true;
+        }
+        double cut = 0.0;
+        SteadyStateMonitor::Decision decision = monitor.check(cut);
+        if (decision == SteadyStateMonitor::WARMED_UP) {
+            // The statistics cannot be rolled back to the cut, so a transient
+            // restarts them now, discarding a little more than it must
+            warmupCut = cut;
+            if (cut > 0.0) beginMeasurement();
+        } else if (decision == SteadyStateMonitor::PRECISE) {
+            stopped = true;
+            measureEnd = currentTime;
+            return false;
+        }
+        scheduleEvent(Event(Event::RUN_CONTROL, checkTime(e.index + 1), e.index + 1));
+        return true;
+    }
+
+    // Handles one event; returns false, keeping the event, once it lies beyond `until`
+    bool dispatch(const Event& currentEvent, double until) {
+        if (currentEvent.time > until && until < simulationTime) {
+            held = currentEvent;
+            holding = true;
+            return false;
+        }
+        currentTime = currentEvent.time;
+        if (currentTime > simulationTime) return false;
+
+        if (currentEvent.type == Event::PACKET_ARRIVAL) {
+            EngineCounters::Scope scope(counters, Handler::ARRIVAL);
+            serveLane(arrivalStreams[currentEvent.index], Event::PACKET_ARRIVAL, currentEvent.index);
+        } else if (currentEvent.type == Event::PACKET_DEPARTURE) {
+            EngineCounters::Scope scope(counters, Handler::DEPARTURE);
+            handleDepartureEvent(currentEvent);
+        } else if (currentEvent.type == Event::REPLAY_ARRIVAL) {
+            EngineCounters::Scope scope(counters, Handler::REPLAY_ARRIVAL);
+            serveLane(replayLane, Event::REPLAY_ARRIVAL, 0);
+        } else if (currentEvent.type == Event::RUN_CONTROL) {
+            EngineCounters::Scope scope(counters, Handler::RUN_CONTROL);
+            return handleRunControl(currentEvent); // Neither are counted as simulation events
+        } else {
+#ifndef SIM_NO_TIMESERIES
+            EngineCounters::Scope scope(counters, Handler::METRICS_SAMPLE);
+            handleSampleEvent(currentEvent);
+#endif
+            return true; // Samples are not counted as simulation events
+        }
+        ++eventsProcessed;
+        return true;
+    }
+
+#ifndef SIM_NO_TIMESERIES
+    static const bool kWithSeries = true;
+#else
+    static const bool kWithSeries = false;
+#endif
+
+public:
+    /**
+     * @brief Parses configuration from the input file.
+     */
+    void loadConfig(const std::string& filename) {
+        configure(::loadConfig(filename));
+    }
+
+    /**
+     * @brief Applies an already parsed configuration.
+     */
+    void configure(const Config& config) {
+        if (hasFlowClasses(config)) throw std::runtime_error("Flow classes run in flow mode (--flows)");
+        scenario = config;
+        numSources = config.numSources;
+        simulationTime = config.simulationTime;
+        linkCapacity = config.linkCapacity;
+        currentTime = 0.0;
+        linkBusy = false;
+        holding = false;
+        measureStart = 0.0;
+        warmupCut = -1.0;
+        measureEnd = simulationTime;
+        stopped = false;
+        nextPacketId = 1;
+        eventsProcessed = 0;
+        stats.reset(numSources);
+        eventQueue.clear();
+
+        sources.clear();
+        weights.clear();
+        std::vector<std::shared_ptr<const EmpiricalSizes>> tables;
+        for (const auto& table : config.sizeTables) tables.push_back(std::make_shared<const EmpiricalSizes>(table));
+        for (int i = 0; i < numSources; ++i) {
+            const SourceConfig& sc = config.sources[i];
+            sources.emplace_back(i, sc.packetRate, sc.minSize, sc.maxSize, sc.weight,
+                                 sc.startFraction * simulationTime, sc.endFraction * simulationTime);
+            sources.back().traffic = trafficModel(config, i);
+            if (sources.back().traffic.sizeTable >= 0) sources.back().sizeTable = tables[sources.back().traffic.sizeTable];
+            weights.push_back(sc.weight);
+        }
+        // Buffered packets, plus the one in transmission and the one arriving
+        pool.reset(bufferedPacketBound(config) + 2);
+        packetBuffer.configure(config, pool);
+        aqmStage.configure(config);
+    }
+
+    /**
+     * @brief Applies run-time switches; call before seed() and run().
+     */
+    void setRunOptions(const RunOptions& runOptions) {
+        options = runOptions;
+        rng.setEngine(options.randomEngine);
+        aqmStage.select(options.aqm);
+    }
+
+    /**
+     * @brief Executes the discrete-event simulation loop.
+     */
+    void run() {
+        start();
+        advance(simulationTime);
+    }
+
+    /**
+     * @brief Primes the event queue for a run driven by advance().
+     */
+    void start() {
+        if (options.warmup >= simulationTime) {
+            throw std::runtime_error("Warm-up must end before the simulation time");
+        }
+        queuedBytes = 0.0;
+        holding = false;
+        counters.reset();
+        aqmStage.reset();
+
+        // Prime the event queue with the head of every arrival lane
+        if (replay) {
+            arrivalStreams.clear();
+            replayLane = ReplayGenerator(replay, numSources);
+            startLane(replayLane, Event::REPLAY_ARRIVAL, 0);
+        } else {
+            arrivalStreams = buildArrivalStreams(sources, options.aggregateArrivals);
+            for (size_t i = 0; i < arrivalStreams.size(); ++i) {
+                startLane(arrivalStreams[i], Event::PACKET_ARRIVAL, static_cast<uint32_t>(i));
+            }
+        }
+#ifndef SIM_NO_TIMESERIES
+        series.configure(options.metricsWindow, options.metricsCapacity, sources.size());
+        if (series.enabled()) scheduleEvent(Event(Event::METRICS_SAMPLE, series.sampleTime(0), 0));
+#endif
+
+        monitor.configure(options.autoWarmup, options.precision);
+        if (!options.autoWarmup) {
+            if (options.warmup > 0.0) {
+                scheduleEvent(Event(Event::RUN_CONTROL, options.warmup, 0));
+            } else {
+                monitor.endWarmup();
+            }
+        }
+        if (monitor.enabled()) scheduleEvent(Event(Event::RUN_CONTROL, checkTime(1), 1));
+    }
+
+    /**
+     * @brief Handles every event up to and including time `until`; the run
+     * is complete once `until` reaches simulationTime.
+     */
+    void advance(double until) {
+        if (stopped) return;
+        EngineCounters::Scope scope(counters, Handler::RUN_LOOP);
+        if (holding) {
+            holding = false;
+            if (!dispatch(held, until)) return;
+        }
+        while (!eventQueue.empty()) {
+            if (!dispatch(eventQueue.pop(), until)) return;
+        }
+    }
+
+    /**
+     * @brief Runs a started or restored simulation to the end.
+     */
+    void resume() {
+        advance(simulationTime);
+    }
+
+    /// @brief Time of the last event handled.
+    double now() const { return currentTime; }
+
+    /// @brief Start of the measured interval: 0, or the end of the warm-up.
+    double measurementStart() const { return measureStart; }
+
+    /// @brief Where MSER-5 placed the end of the transient; negative until detected.
+    double warmupCutTime() const { return warmupCut; }
+
+    /// @brief Whether the run stopped at now() on its precision target.
+    bool stoppedEarly() const { return stopped; }
+
+    /// @brief Batch-means estimate of the mean delay; set when precision is.
+    Estimate delayEstimate() const { return monitor.delayEstimate(); }
+
+    /**
+     * @brief Snapshots a run paused by advance(): the scenario, the run
+     * options and the complete engine state. Replayed runs are not supported,
+     * since the engine does not own the trace file position.
+     */
+    std::string checkpoint() const {
+        if (replay) throw std::runtime_error("Replayed runs cannot be checkpointed");
+        StateWriter out;
+        out.putString(Discipline::name());
+        out.putString(EventQueue::name());
+        bool withSeries = kWithSeries;
+        out.put(withSeries);
+        out.put(scenario.numSources, scenario.simulationTime, scenario.linkCapacity,
+                scenario.bufferSize, scenario.bufferBytes);
+        out.putVector(scenario.sources);
+        out.putVector(scenario.traffic);
+        out.put(static_cast<uint64_t>(scenario.sizeTables.size()));
+        for (const auto& table : scenario.sizeTables) {
+            out.putVector(table.sizes);
+            out.putVector(table.weights);
+        }
+        out.put(options);
+
+        out.put(currentTime, linkBusy, nextPacketId, eventsProcessed, queuedBytes, holding, held);
+        out.put(measureStart, measureEnd, warmupCut, stopped);
+        monitor.saveState(out);
+        out.put(static_cast<uint64_t>(arrivalStreams.size()));
+        for (const auto& stream : arrivalStreams) stream.saveState(out);
+        pool.saveState(out);
+        packetBuffer.saveState(out);
+        eventQueue.saveState(out);
+        rng.saveState(out);
+        aqmStage.saveState(out);
+        stats.saveState(out);
+#ifndef SIM_NO_TIMESERIES
+        series.saveState(out);
+#endif
+        return out.finish();
+    }
+
+    /**
+     * @brief Loads a snapshot taken by checkpoint() with the same discipline
+     * and event queue, replacing the configuration and run options; follow
+     * with resume(). seed() afterwards branches the run onto a new stream.
+     */
+    void restore(const char* data, size_t size) {
+        StateReader in(data, size);
+        std::string discipline = in.getString();
+        if (discipline != Discipline::name()) {
+            throw std::runtime_error("Checkpoint was taken with the " + discipline + " scheduler");
+        }
+        std::string queue = in.getString();
+        if (queue != EventQueue::name()) {
+            throw std::runtime_error("Checkpoint was taken with the " + queue + " event queue");
+        }
+        bool withSeries = false;
+        in.get(withSeries);
+        if (withSeries != kWithSeries) throw std::runtime_error("Checkpoint was taken by a different build");
+
+        Config config;
+        in.get(config.numSources, config.simulationTime, config.linkCapacity,
+               config.bufferSize, config.bufferBytes);
+        in.getVector(config.sources);
+        in.getVector(config.traffic);
+        uint64_t tables = 0;
+        in.get(tables);
+        if (config.numSources < 0 || static_cast<size_t>(config.numSources) != config.sources.size() ||
+            (!config.traffic.empty() && config.traffic.size() != config.sources.size()) || tables > size) {
+            throw std::runtime_error("Corrupt checkpoint scenario");
+        }
+        config.sizeTables.resize(tables);
+        for (auto& table : config.sizeTables) {
+            in.getVector(table.sizes);
+            in.getVector(table.weights, table.sizes.size());
+        }
+        for (size_t i = 0; i < config.sources.size(); ++i) {
+            if (trafficProblem(config, i)) throw std::runtime_error("Corrupt checkpoint scenario");
+        }
+        RunOptions runOptions;
+        in.get(runOptions);
+        replay = nullptr;
+        configure(config);
+        setRunOptions(runOptions);
+        aqmStage.reset();
+        counters.reset();
+        arrivalStreams = buildArrivalStreams(sources, options.aggregateArrivals);
+#ifndef SIM_NO_TIMESERIES
+        series.configure(options.metricsWindow, options.metricsCapacity, sources.size());
+#endif
+
+        in.get(currentTime, linkBusy, nextPacketId, eventsProcessed, queuedBytes, holding, held);
+        in.get(measureStart, measureEnd, warmupCut, stopped);
+        monitor.configure(options.autoWarmup, options.precision);
+        monitor.loadState(in);
+        uint64_t streams = 0;
+        in.get(streams);
+        if (streams != arrivalStreams.size()) throw std::runtime_error("Checkpoint does not match the configured scenario");
+        for (auto& stream : arrivalStreams) stream.loadState(in);
+        pool.loadState(in);
+        packetBuffer.loadState(in);
+        eventQueue.loadState(in);
+        rng.loadState(in);
+        aqmStage.loadState(in);
+        stats.loadState(in);
+#ifndef SIM_NO_TIMESERIES
+        series.loadState(in);
+#endif
+        if (!in.atEnd()) throw std::runtime_error("Checkpoint does not match the configured scenario");
+    }
+
+    void restore(const std::string& snapshot) {
+        restore(snapshot.data(), snapshot.size());
+    }
+
+    /// @brief The configuration in effect, e.g. as loaded by restore().
+    const Config& config() const { return scenario; }
+
+    /// @brief The run options in effect, e.g. as loaded by restore().
+    const RunOptions& runOptions() const { return options; }
+
+    /**
+     * @brief Streams every arrival, drop and departure to `sink`, or stops
+     * tracing when null. The sink must outlive run().
+     */
+    void setTrace(TraceWriter* sink) {
+        trace = sink;
+    }
+
+    /**
+     * @brief Drives arrivals from `stream` instead of the configured sources,
+     * or restores them when null. Flow f arrives at source f % numSources;
+     * the sources keep their weights but their rates and sizes are unused.
+     * The stream must be freshly opened for each run() and outlive it.
+     */
+    void setReplay(ReplayStream* stream) {
+        replay = stream;
+    }
+
+    /**
+     * @brief Reseeds the random engine; replications use distinct seeds so
+     * that each one draws an independent stream.
+     */
+    void seed(uint64_t seedValue) {
+        rng.seed(seedValue);
+    }
+
+#ifndef SIM_NO_TIMESERIES
+    /// @brief Per-window metrics of the last run; empty unless RunOptions::metricsWindow > 0.
+    const TimeSeries& timeSeries() const { return series; }
+#endif
+
+    /// @brief The early-drop stage, for its drop count after run().
+    const AQMStage& aqm() const { return aqmStage; }
+
+    /// @brief Hot-path counters since start() or restore(); empty without SIM_INSTRUMENT.
+    const EngineCounters& instrumentation() const { return counters; }
+
+    /// @brief Number of events handled by the last run().
+    uint64_t eventCount() const { return eventsProcessed; }
+
+    /**
+     * @brief Calculates the system and per-source metrics of the last run.
+     */
+    Metrics metrics() const {
+        Metrics m;
+        LogHistogram allDelays;
+        double measured = measureEnd - measureStart;
+        m.sources.reserve(numSources);
+        for (int i = 0; i < numSources; ++i) {
+            allDelays.merge(stats.delays[i]);
+
+            SourceMetrics sm;
+            sm.weight = sources[i].weight;
+            sm.packetsGenerated = stats.packetsGenerated[i];
+            sm.packetsTransmitted = stats.packetsTransmitted[i];
+            sm.packetsDropped = stats.packetsDropped[i];
+            sm.dropRate = sm.packetsGenerated > 0 ? (double)sm.packetsDropped / sm.packetsGenerated : 0.0;
+            sm.avgDelay = sm.packetsTransmitted > 0 ? stats.totalDelay[i] / sm.packetsTransmitted : 0.0;
+            sm.delayP50 = stats.delays[i].quantile(0.5);
+            sm.delayP99 = stats.delays[i].quantile(0.99);
+            sm.delayP999 = stats.delays[i].quantile(0.999);
+            sm.throughput = stats.bytesTransmitted[i] / measured;
+            m.sources.push_back(sm);
+        }
+
+        StatsTotals t = stats.totals();
+        m.utilization = (t.bytesTransmitted / linkCapacity) / measured;
+        m.avgDelay = t.packetsTransmitted > 0 ? (t.totalDelay / t.packetsTransmitted) : 0.0;
+        m.dropProbability = t.packetsGenerated > 0 ? (double)t.packetsDropped / t.packetsGenerated : 0.0;
+        // Weighted disciplines judge fairness on weight-normalized throughput
+        m.fairness = stats.fairness(Discipline::weightedFairness ? weights.data() : nullptr);
+        m.delayP50 = allDelays.quantile(0.5);
+        m.delayP99 = allDelays.quantile(0.99);
+        m.delayP999 = allDelays.quantile(0.999);
+        m.measureStart = measureStart;
+        m.measureEnd = measureEnd;
+        return m;
+    }
+
+    /**
+     * @brief Calculates metrics and outputs them to the provided stream.
+     */
+    void printResults(std::ostream& out) const {
+        Metrics m = metrics();
+
+        out << std::fixed << std::setprecision(6);
+        out << "## System-Level Performance Metrics (" << Discipline::name() << ")\n"
+            << "1. Server Utilization:   " << m.utilization << "\n"
+            << "2. Avg. Packet Delay:    " << m.avgDelay << " s\n"
+            << "3. Packet Drop Prob.:    " << m.dropProbability << "\n"
+            << "4. Fairness Index:       " << m.fairness << "\n\n";
+
+        out << "## Per-Source Statistics\n"
+            << "---------------------------------------------------------------------------------------\n"
+            << "Src | Weight | Gen'd Pkts | Trans'd Pkts | Drop'd Pkts | Drop Rate | Avg Delay (s) | Thruput (B/s)\n"
+            << "---------------------------------------------------------------------------------------\n";
+
+        for (int i = 0; i < numSources; ++i) {
+            const SourceMetrics& sm = m.sources[i];
+            out << std::setw(3) << i << " | "
+                << std::setw(6) << sm.weight << " | "
+                << std::setw(10) << sm.packetsGenerated << " | "
+                << std::setw(12) << sm.packetsTransmitted << " | "
+                << std::setw(11) << sm.packetsDropped << " | "
+                << std::setw(9) << std::setprecision(4) << sm.dropRate << " | "
+                << std::setw(13) << std::setprecision(6) << sm.avgDelay << " | "
+                << std::setw(13) << std::setprecision(2) << sm.throughput << "\n";
+        }
+        out << "---------------------------------------------------------------------------------------\n";
+
+        out << "\n## Delay Percentiles (s)\n"
+            << "------------------------------------------\n"
+            << "Src |      p50     |      p99     |     p99.9\n"
+            << "------------------------------------------\n"
+            << std::setprecision(6);
+        for (int i = 0; i < numSources; ++i) {
+            const SourceMetrics& sm = m.sources[i];
+            out << std::setw(3) << i << " | " << std::setw(12) << sm.delayP50 << " | "
+                << std::setw(12) << sm.delayP99 << " | " << std::setw(12) << sm.delayP999 << "\n";
+        }
+        out << "All | " << std::setw(12) << m.delayP50 << " | "
+            << std::setw(12) << m.delayP99 << " | " << std::setw(12) << m.delayP999 << "\n"
+            << "------------------------------------------\n";
+        counters.print(out);
+    }
+};
+
+#endif // SIM_SIMULATOR_H
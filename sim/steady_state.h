@@ -0,0 +1,302 @@
+/**
+ * @file steady_state.h
+ * @brief Warm-up detection and run-length control on the streaming delay series.
+ * A run starts from an empty system, so its first departures see shorter
+ * delays than the steady state. MSERDetector finds where that transient ends
+ * with MSER-5 (White, 1997): the delays are averaged in batches of five and
+ * the truncation point is the batch d minimizing the marginal standard error
+ *   MSER(d) = sum_{i>=d} (Y_i - mean_d)^2 / (n - d)^2
+ * of the batch means left after it. BatchMeans then estimates the mean delay
+ * with a confidence interval from a fixed number of batches whose size
+ * doubles as the run grows, so the run can stop once the interval is narrow
+ * enough. Both keep bounded memory and cost O(1) per departure.
+ */
+
+#ifndef SIM_STEADY_STATE_H
+#define SIM_STEADY_STATE_H
+
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "checkpoint.h"
+
+/// @brief Sample mean with the half-width of its 95% confidence interval.
+struct Estimate {
+    double mean = 0.0;
+    double halfWidth = 0.0; // NaN when one sample leaves it undefined
+};
+
+/// @brief Two-sided 95% Student-t quantile for the given degrees of freedom.
+inline double studentT975(size_t df) {
+    static const double table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    if (df == 0) return 0.0;
+    if (df <= 30) return table[df - 1];
+    // Cornish-Fisher style correction towards the normal quantile
+    return 1.959964 + 2.37 / df;
+}
+
+inline Estimate estimate(const std::vector<double>& samples) {
+    Estimate e;
+    size_t n = samples.size();
+    if (n == 0) return e;
+
+    double sum = 0.0;
+    for (double x : samples) sum += x;
+    e.mean = sum / n;
+    if (n < 2) {
+        e.halfWidth = std::numeric_limits<double>::quiet_NaN();
+        return e;
+    }
+
+    double sq = 0.0;
+    for (double x : samples) sq += (x - e.mean) * (x - e.mean);
+    double stddev = std::sqrt(sq / (n - 1));
+    e.halfWidth = studentT975(n - 1) * stddev / std::sqrt(static_cast<double>(n));
+    return e;
+}
+
+/**
+ * @brief Streaming MSER-5 truncation point. The batch means are kept while
+ * the warm-up is searched for; past kMaxBatches adjacent pairs are merged,
+ * which turns the test into MSER-10, MSER-20 and so on for long transients.
+ */
+class MSERDetector {
+private:
+    static const size_t kMaxBatches = 1 << 14;
+    static const size_t kMinBatches = 100; // Fewer leave the minimum to noise
+    static const size_t kMinTail = 10;     // Candidate cuts keep at least this many batches
+
+    size_t batchSize = 5;
+    size_t pendingCount = 0;
+    double pendingSum = 0.0;
+    std::vector<double> means;
+    std::vector<double> endTimes; // Time of the last observation of each batch
+
+public:
+    void reset() {
+        batchSize = 5;
+        pendingCount = 0;
+        pendingSum = 0.0;
+        means.clear();
+        endTimes.clear();
+    }
+
+    void observe(double time, double x) {
+        pendingSum += x;
+        if (++pendingCount < batchSize) return;
+        means.push_back(pendingSum / batchSize);
+        endTimes.push_back(time);
+        pendingSum = 0.0;
+        pendingCount = 0;
+        if (means.size() == kMaxBatches) {
+            for (size_t i = 0; i < kMaxBatches / 2; ++i) {
+                means[i] = 0.5 * (means[2 * i] + means[2 * i + 1]);
+                endTimes[i] = endTimes[2 * i + 1];
+            }
+            means.resize(kMaxBatches / 2);
+            endTimes.resize(kMaxBatches / 2);
+            batchSize *= 2;
+        }
+    }
+
+    /**
+     * @brief Searches the batches so far for the MSER minimum. Returns true,
+     * with the time the transient ended, when the minimum lies in the first
+     * half of the series; a later minimum means the run is still warming up.
+     */
+    bool truncation(double& cutTime) const {
+        size_t n = means.size();
+        if (n < kMinBatches) return false;
+        // Suffix sums give every MSER(d) in one backward pass
+        double s1 = 0.0, s2 = 0.0;
+        double best = 0.0;
+        size_t bestCut = n;
+        for (size_t d = n; d-- > 0;) {
+            s1 += means[d];
+            s2 += means[d] * means[d];
+            size_t tail = n - d;
+            if (tail < kMinTail) continue;
+            double mser = (s2 - s1 * s1 / tail) / (static_cast<double>(tail) * tail);
+            if (bestCut == n || mser <= best) {
+                best = mser;
+                bestCut = d;
+            }
+        }
+        if (bestCut >= n / 2) return false;
+        cutTime = bestCut == 0 ? 0.0 : endTimes[bestCut - 1];
+        return true;
+    }
+
+    void saveState(StateWriter& out) const {
+        out.put(batchSize, pendingCount, pendingSum);
+        out.putVector(means);
+        out.putVector(endTimes);
+    }
+
+    void loadState(StateReader& in) {
+        in.get(batchSize, pendingCount, pendingSum);
+        in.getVector(means);
+        in.getVector(endTimes, means.size());
+    }
+};
+
+/**
+ * @brief Nonoverlapping batch means with between kBatches and twice as many
+ * batches: when the upper count is reached adjacent batches merge and the
+ * batch size doubles (the LBATCH scheme of Fishman & Yarberry, 1997).
+ */
+class BatchMeans {
+private:
+    static const size_t kBatches = 32;
+
+    size_t batchSize = 1;
+    size_t pendingCount = 0;
+    double pendingSum = 0.0;
+    uint64_t observed = 0;
+    std::vector<double> means;
+
+public:
+    void reset() {
+        batchSize = 1;
+        pendingCount = 0;
+        pendingSum = 0.0;
+        observed = 0;
+        means.clear();
+    }
+
+    void observe(double x) {
+        ++observed;
+        pendingSum += x;
+        if (++pendingCount < batchSize) return;
+        means.push_back(pendingSum / batchSize);
+        pendingSum = 0.0;
+        pendingCount = 0;
+        if (means.size() == 2 * kBatches) {
+            for (size_t i = 0; i < kBatches; ++i) means[i] = 0.5 * (means[2 * i] + means[2 * i + 1]);
+            means.resize(kBatches);
+            batchSize *= 2;
+        }
+    }
+
+    uint64_t observations() const { return observed; }
+
+    /// @brief Mean of the completed batches with its 95% confidence interval.
+    Estimate mean() const { return estimate(means); }
+
+    /**
+     * @brief True once there are kBatches batches and their lag-1
+     * autocorrelation is small enough for them to pass as independent.
+     */
+    bool independent() const {
+        size_t n = means.size();
+        if (n < kBatches) return false;
+        Estimate e = mean();
+        double c0 = 0.0, c1 = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            double x = means[i] - e.mean;
+            c0 += x * x;
+            if (i + 1 < n) c1 += x * (means[i + 1] - e.mean);
+        }
+        return c0 > 0.0 && c1 / c0 < 0.2;
+    }
+
+    void saveState(StateWriter& out) const {
+        out.put(batchSize, pendingCount, pendingSum, observed);
+        out.putVector(means);
+    }
+
+    void loadState(StateReader& in) {
+        in.get(batchSize, pendingCount, pendingSum, observed);
+        in.getVector(means);
+    }
+};
+
+/**
+ * @brief Per-run warm-up and stopping decisions fed with every departure's
+ * delay. Until the warm-up ends the delays go to the MSER detector (when
+ * detecting); afterwards to the batch means (when a precision is set).
+ */
+class SteadyStateMonitor {
+private:
+    bool detectWarmup = false;
+    double precision = 0.0;
+    bool warmedUp = false;
+    MSERDetector mser;
+    BatchMeans batches;
+
+public:
+    enum Decision { CONTINUE, WARMED_UP, PRECISE };
+
+    /**
+     * @param detect Find the warm-up end with MSER-5; otherwise the engine
+     *        calls endWarmup() itself at a fixed cutoff.
+     * @param relativePrecision Target CI half-width over the mean delay, or 0.
+     */
+    void configure(bool detect, double relativePrecision) {
+        detectWarmup = detect;
+        precision = relativePrecision;
+        warmedUp = false;
+        mser.reset();
+        batches.reset();
+    }
+
+    /// @brief Whether the engine must report delays and schedule checks.
+    bool enabled() const { return detectWarmup || precision > 0.0; }
+    bool inWarmup() const { return !warmedUp; }
+
+    void observe(double time, double delay) {
+        if (!warmedUp) {
+            if (detectWarmup) mser.observe(time, delay);
+        } else if (precision > 0.0) {
+            batches.observe(delay);
+        }
+    }
+
+    void endWarmup() {
+        warmedUp = true;
+        mser.reset();
+    }
+
+    /**
+     * @brief Periodic decision. WARMED_UP sets `cutTime` to the detected end
+     * of the transient; PRECISE means the mean-delay interval met the target.
+     */
+    Decision check(double& cutTime) {
+        if (!warmedUp) {
+            if (detectWarmup && mser.truncation(cutTime)) {
+                endWarmup();
+                return WARMED_UP;
+            }
+            return CONTINUE;
+        }
+        if (precision > 0.0 && batches.independent()) {
+            Estimate e = batches.mean();
+            if (e.mean > 0.0 && e.halfWidth <= precision * e.mean) return PRECISE;
+        }
+        return CONTINUE;
+    }
+
+    /// @brief Batch-means estimate of the post-warm-up mean delay.
+    Estimate delayEstimate() const { return batches.mean(); }
+
+    void saveState(StateWriter& out) const {
+        out.put(warmedUp);
+        mser.saveState(out);
+        batches.saveState(out);
+    }
+
+    void loadState(StateReader& in) {
+        in.get(warmedUp);
+        mser.loadState(in);
+        batches.loadState(in);
+    }
+};
+
+#endif // SIM_STEADY_STATE_H
@@ -0,0 +1,274 @@
+/**
+ * @file sweep.h
+ * @brief Parameter sweeps over a parsed scenario.
+ * A sweep is the cartesian product of a few axes ("buffer=50,100,200",
+ * "buffer_bytes=2e4,5e4", "capacity=8e4,1e5", "weight.2=1,2,4"). Every
+ * grid point is run, optionally replicated, on a shared worker pool. The
+ * input file is parsed once and each worker reuses one Simulator (and its
+ * allocations) for all of its jobs.
+ * An optional analytic prescreen (analytic.h) skips points whose M/G/1/K
+ * estimate already rules them out; their rows carry that estimate and zero
+ * replications.
+ */
+
+#ifndef SIM_SWEEP_H
+#define SIM_SWEEP_H
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <stdexcept>
+#include <cstdlib>
+#include <cmath>
+#include <limits>
+
+#include "config.h"
+#include "replications.h"
+#include "analytic.h"
+
+/// @brief One swept parameter and the values it takes.
+struct SweepAxis {
+    enum Kind { BUFFER_SIZE, BUFFER_BYTES, LINK_CAPACITY, SOURCE_WEIGHT };
+
+    std::string name; // As given on the command line, used as the column header
+    Kind kind;
+    int sourceID = -1; // For SOURCE_WEIGHT
+    std::vector<double> values;
+};
+
+/**
+ * @brief Parses "<param>=<v1>,<v2>,..." where param is buffer, buffer_bytes,
+ * capacity or weight.<source>.
+ */
+inline SweepAxis parseSweepAxis(const std::string& spec, const Config& config) {
+    size_t eq = spec.find('=');
+    if (eq == std::string::npos || eq == 0) {
+        throw std::invalid_argument("Sweep axis must look like <param>=<v1>,<v2>,...: " + spec);
+    }
+
+    SweepAxis axis;
+    axis.name = spec.substr(0, eq);
+    if (axis.name == "buffer") {
+        axis.kind = SweepAxis::BUFFER_SIZE;
+    } else if (axis.name == "buffer_bytes") {
+        axis.kind = SweepAxis::BUFFER_BYTES;
+    } else if (axis.name == "capacity") {
+        axis.kind = SweepAxis::LINK_CAPACITY;
+    } else if (axis.name.compare(0, 7, "weight.") == 0) {
+        axis.kind = SweepAxis::SOURCE_WEIGHT;
+        char* end = nullptr;
+        long id = std::strtol(axis.name.c_str() + 7, &end, 10);
+        if (*end != '\0' || end == axis.name.c_str() + 7 || id < 0 || id >= config.numSources) {
+            throw std::invalid_argument("Sweep axis names an unknown source: " + axis.name);
+        }
+        axis.sourceID = static_cast<int>(id);
+    } else {
+        throw std::invalid_argument("Unknown sweep parameter: " + axis.name);
+    }
+
+    std::stringstream list(spec.substr(eq + 1));
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        char* end = nullptr;
+        double v = std::strtod(item.c_str(), &end);
+        if (item.empty() || *end != '\0') throw std::invalid_argument("Bad sweep value '" + item + "' in " + spec);
+        bool bufferAxis = axis.kind == SweepAxis::BUFFER_SIZE || axis.kind == SweepAxis::BUFFER_BYTES;
+        if (bufferAxis && v < 0) throw std::invalid_argument(axis.name + " must be >= 0");
+        if (bufferAxis && (v != std::floor(v) || std::isinf(v))) {
+            throw std::invalid_argument(axis.name + " takes whole numbers: " + item);
+        }
+        if (!bufferAxis && v <= 0) throw std::invalid_argument(axis.name + " must be positive");
+        axis.values.push_back(v);
+    }
+    if (axis.values.empty()) throw std::invalid_argument("Sweep axis has no values: " + spec);
+    return axis;
+}
+
+/// @brief Number of grid points spanned by the axes.
+inline size_t sweepSize(const std::vector<SweepAxis>& axes) {
+    size_t n = 1;
+    for (const auto& a : axes) n *= a.values.size();
+    return n;
+}
+
+/// @brief Value index on each axis of grid point `point` (last axis fastest).
+inline std::vector<size_t> sweepCoordinates(const std::vector<SweepAxis>& axes, size_t point) {
+    std::vector<size_t> coords(axes.size());
+    for (size_t a = axes.size(); a-- > 0;) {
+        coords[a] = point % axes[a].values.size();
+        point /= axes[a].values.size();
+    }
+    return coords;
+}
+
+/// @brief Overwrites `target` with `base` adjusted to grid point `point`.
+inline void applySweepPoint(const Config& base, const std::vector<SweepAxis>& axes,
+                            size_t point, Config& target) {
+    target.numSources = base.numSources;
+    target.simulationTime = base.simulationTime;
+    target.linkCapacity = base.linkCapacity;
+    target.bufferSize = base.bufferSize;
+    target.bufferBytes = base.bufferBytes;
+    target.sources.assign(base.sources.begin(), base.sources.end()); // Reuses capacity
+    target.traffic.assign(base.traffic.begin(), base.traffic.end());
+    target.sizeTables = base.sizeTables;
+
+    std::vector<size_t> coords = sweepCoordinates(axes, point);
+    for (size_t a = 0; a < axes.size(); ++a) {
+        double v = axes[a].values[coords[a]];
+        switch (axes[a].kind) {
+            case SweepAxis::BUFFER_SIZE: target.bufferSize = static_cast<size_t>(v); break;
+            case SweepAxis::BUFFER_BYTES: target.bufferBytes = static_cast<size_t>(v); break;
+            case SweepAxis::LINK_CAPACITY: target.linkCapacity = v; break;
+            case SweepAxis::SOURCE_WEIGHT: target.sources[axes[a].sourceID].weight = v; break;
+        }
+    }
+}
+
+/// @brief Summary row of a point the prescreen excluded.
+inline ReplicationSummary screenedSummary(const AnalyticEstimate& e) {
+    // Metrics the estimate does not give are undefined, not zero
+    const double undefined = std::numeric_limits<double>::quiet_NaN();
+    ReplicationSummary s;
+    Estimate* metrics[] = {&s.utilization, &s.avgDelay, &s.dropProbability, &s.fairness,
+                           &s.delayP50, &s.delayP99, &s.delayP999};
+    for (Estimate* m : metrics) m->mean = m->halfWidth = undefined;
+    s.utilization.mean = e.utilization;
+    s.avgDelay.mean = e.avgDelay;
+    s.dropProbability.mean = e.dropProbability;
+    return s;
+}
+
+/**
+ * @brief Runs every grid point `replications` times on `threads` workers and
+ * returns one summary per point, in grid order. Replication r of every point
+ * uses the same seed, so points are compared under common random numbers.
+ * Points failing `screen` are not run; `controlVariate` adjusts the others
+ * with the arrival-count control. `onRun` sees every run as it finishes,
+ * with index point * replications + replication.
+ */
+template <class Sim>
+std::vector<ReplicationSummary> runSweep(const Config& base, const std::vector<SweepAxis>& axes,
+                                         size_t replications, unsigned threads, uint64_t baseSeed,
+                                         const RunOptions& options, const AnalyticScreen* screen = nullptr,
+                                         bool controlVariate = false, const RunCallback& onRun = nullptr) {
+    size_t points = sweepSize(axes);
+    std::vector<Metrics> results(points * replications);
+
+    unsigned workers = std::max(1u, threads);
+    std::vector<Sim> simulators(workers);
+    std::vector<Config> scratch(workers);
+
+    // The prescreen is cheap next to one simulation, so it runs up front
+    std::vector<size_t> kept;
+    std::vector<AnalyticEstimate> screened(points);
+    std::vector<bool> simulate(points, true);
+    for (size_t p = 0; p < points; ++p) {
+        if (screen) {
+            applySweepPoint(base, axes, p, scratch[0]);
+            screened[p] = analyzeScenario(scratch[0], true).mg1k;
+            simulate[p] = screen->passes(screened[p]);
+        }
+        if (simulate[p]) kept.push_back(p);
+    }
+
+    parallelFor(kept.size() * replications, workers, [&](size_t k, unsigned worker) {
+        size_t point = kept[k / replications];
+        size_t r = k % replications;
+        size_t job = point * replications + r;
+        applySweepPoint(base, axes, point, scratch[worker]);
+
+        Sim& sim = simulators[worker];
+        sim.configure(scratch[worker]);
+        sim.setRunOptions(options);
+        sim.seed(baseSeed * 0x9E3779B97F4A7C15ULL + r);
+        sim.run();
+        results[job] = sim.metrics();
+        if (onRun) onRun(job, results[job]);
+    });
+
+    std::vector<ReplicationSummary> summaries;
+    std::vector<Metrics> runs(replications);
+    std::vector<double> controls(replications);
+    for (size_t p = 0; p < points; ++p) {
+        if (!simulate[p]) {
+            summaries.push_back(screenedSummary(screened[p]));
+            continue;
+        }
+        applySweepPoint(base, axes, p, scratch[0]);
+        for (size_t r = 0; r < replications; ++r) {
+            runs[r] = results[p * replications + r];
+            if (controlVariate) controls[r] = arrivalSurplus(runs[r], scratch[0], options.aggregateArrivals);
+        }
+        summaries.push_back(summarize(runs, controlVariate ? &controls : nullptr));
+    }
+    return summaries;
+}
+
+/// @brief Writes `v`, or `missing` when it is not finite (as ResultExporter does).
+inline void putSweepNumber(std::ostream& out, double v, const char* missing) {
+    if (std::isfinite(v)) {
+        out << v;
+    } else {
+        out << missing;
+    }
+}
+
+/**
+ * @brief Writes one row per grid point as CSV or JSON. Values that are not
+ * finite become empty CSV fields and JSON nulls.
+ */
+inline void writeSweepTable(std::ostream& out, const std::string& format,
+                            const std::vector<SweepAxis>& axes,
+                            const std::vector<ReplicationSummary>& summaries) {
+    static const char* metricNames[] = {"utilization", "avg_delay", "drop_probability", "fairness",
+                                        "delay_p50", "delay_p99", "delay_p999"};
+    const size_t numMetrics = sizeof(metricNames) / sizeof(metricNames[0]);
+    out << std::setprecision(9);
+
+    if (format == "csv") {
+        for (const auto& a : axes) out << a.name << ",";
+        out << "replications";
+        for (const char* m : metricNames) out << "," << m << "," << m << "_ci";
+        out << "\n";
+    } else {
+        out << "[\n";
+    }
+
+    for (size_t p = 0; p < summaries.size(); ++p) {
+        const ReplicationSummary& s = summaries[p];
+        const Estimate* values[] = {&s.utilization, &s.avgDelay, &s.dropProbability, &s.fairness,
+                                    &s.delayP50, &s.delayP99, &s.delayP999};
+        std::vector<size_t> coords = sweepCoordinates(axes, p);
+
+        if (format == "csv") {
+            for (size_t a = 0; a < axes.size(); ++a) out << axes[a].values[coords[a]] << ",";
+            out << s.replications;
+            for (const Estimate* e : values) {
+                out << ",";
+                putSweepNumber(out, e->mean, "");
+                out << ",";
+                putSweepNumber(out, e->halfWidth, "");
+            }
+            out << "\n";
+        } else {
+            out << "  {";
+            for (size_t a = 0; a < axes.size(); ++a) {
+                out << "\"" << axes[a].name << "\": " << axes[a].values[coords[a]] << ", ";
+            }
+            out << "\"replications\": " << s.replications;
+            for (size_t m = 0; m < numMetrics; ++m) {
+                out << ", \"" << metricNames[m] << "\": ";
+                putSweepNumber(out, values[m]->mean, "null");
+                out << ", \"" << metricNames[m] << "_ci\": ";
+                putSweepNumber(out, values[m]->halfWidth, "null");
+            }
+            out << "}" << (p + 1 < summaries.size() ? "," : "") << "\n";
+        }
+    }
+    if (format != "csv") out << "]\n";
+}
+
+#endif // SIM_SWEEP_H
@@ -0,0 +1,151 @@
+/**
+ * @file timeseries.h
+ * @brief Interval-sampled metrics: queue length, utilization and per-source
+ * throughput per window of simulated time.
+ * The engine takes a sample from a periodic METRICS_SAMPLE event, so the
+ * arrival and departure handlers do no extra work: each window's figures are
+ * differences of the cumulative counters the engine already keeps, so a
+ * packet's bytes count towards the window in which it departs. Samples
+ * go into fixed-size ring buffers; once full, the oldest windows are
+ * overwritten. Build with -DSIM_NO_TIMESERIES to compile the stage out.
+ */
+
+#ifndef SIM_TIMESERIES_H
+#define SIM_TIMESERIES_H
+
+#include <vector>
+#include <ostream>
+#include <iomanip>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+#include "checkpoint.h"
+
+/// @brief Ring buffers of per-window metrics.
+class TimeSeries {
+private:
+    double window = 0.0;
+    size_t capacity = 0;
+    size_t numSources = 0;
+    size_t head = 0;    // Slot of the oldest retained window
+    size_t count = 0;
+    uint64_t taken = 0; // Samples taken, including overwritten ones
+
+    std::vector<double> endTimes;
+    std::vector<size_t> queueLengths; // Buffered packets at the window end
+    std::vector<double> utilizations;
+    std::vector<double> throughputs;  // capacity x numSources, bytes per second
+    std::vector<double> lastBytes;    // Cumulative bytes per source at the previous sample
+
+public:
+    /**
+     * @brief Clears the series; `windowLength` seconds per sample and at
+     * most `maxWindows` retained.
+     */
+    void configure(double windowLength, size_t maxWindows, size_t sources) {
+        window = windowLength;
+        capacity = windowLength > 0.0 ? maxWindows : 0; // Nothing is allocated when disabled
+        numSources = sources;
+        head = count = 0;
+        taken = 0;
+        endTimes.assign(capacity, 0.0);
+        queueLengths.assign(capacity, 0);
+        utilizations.assign(capacity, 0.0);
+        throughputs.assign(capacity * numSources, 0.0);
+        lastBytes.assign(numSources, 0.0);
+    }
+
+    bool enabled() const { return window > 0.0 && capacity > 0; }
+    double windowLength() const { return window; }
+    size_t size() const { return count; }
+    uint64_t samplesTaken() const { return taken; }
+
+    /// @brief Time at which sample k (0-based) is due.
+    double sampleTime(uint64_t k) const { return (k + 1) * window; }
+
+    /**
+     * @brief Closes the window ending at `time`. `bytesOf(i)` returns source
+     * i's cumulative transmitted bytes.
+     */
+    template <class BytesOf>
+    void sample(double time, size_t queueLength, double linkCapacity, BytesOf bytesOf) {
+        size_t slot = (head + count) % capacity;
+        if (count == capacity) {
+            head = (head + 1) % capacity;
+        } else {
+            ++count;
+        }
+        ++taken;
+
+        double totalBytes = 0.0;
+        double* row = &throughputs[slot * numSources];
+        for (size_t i = 0; i < numSources; ++i) {
+            double bytes = bytesOf(i);
+            double delta = bytes - lastBytes[i];
+            lastBytes[i] = bytes;
+            row[i] = delta / window;
+            totalBytes += delta;
+        }
+        endTimes[slot] = time;
+        queueLengths[slot] = queueLength;
+        utilizations[slot] = totalBytes / (linkCapacity * window);
+    }
+
+    /**
+     * @brief Carries the window in progress across a reset of the cumulative
+     * counters, which held `bytesOf(i)` for source i just before it.
+     */
+    template <class BytesOf>
+    void rebase(BytesOf bytesOf) {
+        for (size_t i = 0; i < lastBytes.size(); ++i) lastBytes[i] -= bytesOf(i);
+    }
+
+    /**
+     * @brief Checkpoint support: the retained windows oldest first, which
+     * restore into the leading slots of a series configured the same way.
+     */
+    void saveState(StateWriter& out) const {
+        out.put(static_cast<uint64_t>(count), taken);
+        for (size_t n = 0; n < count; ++n) {
+            size_t slot = (head + n) % capacity;
+            out.put(endTimes[slot], static_cast<uint64_t>(queueLengths[slot]), utilizations[slot]);
+            for (size_t i = 0; i < numSources; ++i) out.put(throughputs[slot * numSources + i]);
+        }
+        out.putVector(lastBytes);
+    }
+
+    void loadState(StateReader& in) {
+        uint64_t retained = 0;
+        in.get(retained, taken);
+        if (retained > capacity) throw std::runtime_error("Checkpoint does not match the configured time series");
+        head = 0;
+        count = static_cast<size_t>(retained);
+        for (size_t slot = 0; slot < count; ++slot) {
+            uint64_t length = 0;
+            in.get(endTimes[slot], length, utilizations[slot]);
+            queueLengths[slot] = static_cast<size_t>(length);
+            for (size_t i = 0; i < numSources; ++i) in.get(throughputs[slot * numSources + i]);
+        }
+        in.getVector(lastBytes, numSources);
+    }
+
+    /**
+     * @brief Writes the retained windows as CSV, oldest first.
+     */
+    void write(std::ostream& out) const {
+        out << "time,queue_length,utilization";
+        for (size_t i = 0; i < numSources; ++i) out << ",throughput_" << i;
+        out << "\n" << std::fixed << std::setprecision(6);
+
+        for (size_t n = 0; n < count; ++n) {
+            size_t slot = (head + n) % capacity;
+            out << endTimes[slot] << "," << queueLengths[slot] << "," << utilizations[slot];
+            const double* row = &throughputs[slot * numSources];
+            for (size_t i = 0; i < numSources; ++i) out << "," << std::setprecision(2) << row[i];
+            out << std::setprecision(6) << "\n";
+        }
+    }
+};
+
+#endif // SIM_TIMESERIES_H
@@ -0,0 +1,775 @@
+/**
+ * @file topology.h
+ * @brief Networks of links, run by conservative parallel discrete-event simulation.
+ * A topology is a forest of links: each link forwards its departures to one
+ * downstream link or out of the network, so chains and in-trees (many
+ * access links feeding an aggregation link) are described by a single
+ * "next" pointer per link. Sources inject at an ingress link and packets
+ * hop link to link with no propagation delay, each link buffering and
+ * scheduling them with its own instance of the Discipline.
+ *
+ * Links are partitioned across threads, each partition with its own event
+ * queue, packet pool and clock. Partitions advance in windows separated by
+ * barriers. A packet that will cross to another partition is sent as soon
+ * as its transmission starts, stamped with its finish time. That time lies
+ * at least partition p's lookahead L_p = min size / capacity (over p's links
+ * feeding another partition) past p's next event time t_p. The window
+ * therefore ends at min_p (t_p + L_p), and no partition receives a message
+ * it still has to process. Messages travel through lock-free SPSC rings and
+ * are injected at the window boundary.
+ *
+ * Results do not depend on thread timing or on the partition count. Each
+ * link draws from its own random stream, seeded from the run seed and the
+ * link ID. Each partition orders its events by time and then by a stable
+ * key (the source for arrivals, the upstream link for departures and
+ * hand-overs). Ties do happen: sources start together, and back-to-back
+ * packets of equal size finish on consecutive links at the same instant.
+ * They resolve the same way however the links are split. The generic
+ * EventQueue backends break ties by heap position, so they are not used
+ * here.
+ */
+
+#ifndef SIM_TOPOLOGY_H
+#define SIM_TOPOLOGY_H
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+
+#include "simulator.h"
+#include "parallel.h"
+#include "mapped_file.h"
+
+/// @brief One link of a topology.
+struct LinkConfig {
+    double capacity = 0.0;  // Bytes per second
+    size_t bufferSize = 0;  // Packets
+    size_t bufferBytes = 0; // 0 = no byte limit
+    int next = -1;          // Downstream link, or -1 to leave the network
+};
+
+/// @brief A topology file: the links and the sources injecting into them.
+struct TopologyConfig {
+    double simulationTime = 0.0;
+    std::vector<LinkConfig> links;
+    std::vector<SourceConfig> sources;
+    std::vector<int> ingress; // Link each source injects at
+};
+
+/**
+ * @brief Parses a topology file:
+ *   <NUM_LINKS> <NUM_SOURCES> <SIMULATION_TIME>
+ *   <LINK_CAPACITY> <BUFFER_SIZE> <NEXT_LINK> [BUFFER_BYTES]        (per link)
+ *   <LINK> <PACKET_RATE> <MIN_SIZE> <MAX_SIZE> <WEIGHT> <START> <END> (per source)
+ * NEXT_LINK is -1 for a link whose departures leave the network.
+ */
+inline TopologyConfig loadTopology(const std::string& filename) {
+    MappedFile file(filename);
+    ConfigTextReader in(file, filename);
+    TopologyConfig topo;
+    if (!in.nextLine()) throw std::runtime_error("Empty topology file: " + filename);
+
+    int numLinks = 0, numSources = 0;
+    in.require(numLinks, -1, "NUM_LINKS");
+    in.require(numSources, -1, "NUM_SOURCES");
+    in.require(topo.simulationTime, -1, "SIMULATION_TIME");
+    if (numLinks <= 0) in.fail(-1, "NUM_LINKS must be positive");
+    if (numSources < 0) in.fail(-1, "NUM_SOURCES must not be negative");
+    if (!(topo.simulationTime > 0) || std::isinf(topo.simulationTime)) in.fail(-1, "SIMULATION_TIME must be positive");
+    int headerLine = in.line();
+
+    for (int l = 0; l < numLinks; ++l) {
+        if (!in.nextLine()) {
+            throw std::runtime_error(filename + ": link " + std::to_string(l) + " missing; line " +
+                                     std::to_string(headerLine) + " declares " + std::to_string(numLinks) +
+                                     " links but the file has " + std::to_string(l));
+        }
+        LinkConfig link;
+        std::string at = "link " + std::to_string(l) + ": ";
+        in.require(link.capacity, -1, "LINK_CAPACITY");
+        in.require(link.bufferSize, -1, "BUFFER_SIZE");
+        in.require(link.next, -1, "NEXT_LINK");
+        if (!in.field(link.bufferBytes, -1, "BUFFER_BYTES")) link.bufferBytes = 0;
+        if (!(link.capacity > 0) || std::isinf(link.capacity)) in.fail(-1, at + "LINK_CAPACITY must be positive");
+        if (link.next < -1 || link.next >= numLinks || link.next == l) {
+            in.fail(-1, at + "NEXT_LINK must be -1 or another link of the topology");
+        }
+        topo.links.push_back(link);
+    }
+
+    for (int i = 0; i < numSources; ++i) {
+        if (!in.nextLine()) {
+            throw std::runtime_error(filename + ": source " + std::to_string(i) + " missing; line " +
+                                     std::to_string(headerLine) + " declares " + std::to_string(numSources) +
+                                     " sources but the file has " + std::to_string(i));
+        }
+        int link = -1;
+        SourceConfig src;
+        in.require(link, i, "LINK");
+        in.require(src.packetRate, i, "PACKET_RATE");
+        in.require(src.minSize, i, "MIN_SIZE");
+        in.require(src.maxSize, i, "MAX_SIZE");
+        in.require(src.weight, i, "WEIGHT");
+        in.require(src.startFraction, i, "START_TIME_FRACTION");
+        in.require(src.endFraction, i, "END_TIME_FRACTION");
+        if (link < 0 || link >= numLinks) in.fail(i, "LINK must name a link of the topology");
+        if (const char* problem = sourceProblem(src)) in.fail(i, problem);
+        topo.ingress.push_back(link);
+        topo.sources.push_back(src);
+    }
+
+    // Every path must leave the network
+    for (int l = 0; l < numLinks; ++l) {
+        int at = l;
+        for (int hops = 0; at >= 0; ++hops) {
+            if (hops > numLinks) throw std::runtime_error("Topology has a cycle through link " + std::to_string(l));
+            at = topo.links[at].next;
+        }
+    }
+    return topo;
+}
+
+/// @brief Derived per-link figures reported by printResults.
+struct LinkMetrics {
+    int next;
+    double capacity;
+    long packetsTransmitted;
+    long packetsDropped;
+    double utilization;
+    double avgDelay; // Queueing plus transmission at this link
+};
+
+/// @brief End-to-end results of one topology run.
+struct TopologyMetrics {
+    double avgDelay = 0.0;
+    double dropProbability = 0.0;
+    double fairness = 0.0;
+    double delayP50 = 0.0;
+    double delayP99 = 0.0;
+    double delayP999 = 0.0;
+    std::vector<LinkMetrics> links;
+    std::vector<SourceMetrics> sources; // packetsTransmitted counts deliveries
+};
+
+/// @brief A packet handed from a link to a downstream link in another partition.
+struct HopMessage {
+    double time;   // When it finishes on the upstream link and arrives downstream
+    double bornAt; // When its source generated it
+    long id;
+    int sourceID;
+    int size;
+    int from;      // Upstream link
+    int link;      // Downstream link
+};
+
+/// @brief Event plus the key that orders it among events at the same time.
+struct OrderedEvent {
+    Event event;
+    uint64_t tie;
+
+    bool operator>(const OrderedEvent& other) const {
+        if (event.time != other.event.time) return event.time > other.event.time;
+        return tie > other.tie;
+    }
+};
+
+/// @brief Min-heap of OrderedEvents.
+class OrderedEventQueue {
+private:
+    std::vector<OrderedEvent> heap;
+
+public:
+    // Tie keys: arrivals by source, then departures by link. A hand-over
+    // from another partition takes the key of the upstream departure so it
+    // lands where a local hand-over, made inside that departure, would.
+    static uint64_t arrivalKey(int source) { return static_cast<uint64_t>(source); }
+    static uint64_t departureKey(int link) { return (uint64_t(1) << 32) + link; }
+    static uint64_t hopKey(int fromLink) { return departureKey(fromLink); }
+
+    void push(const Event& e, uint64_t tie) {
+        heap.push_back(OrderedEvent{e, tie});
+        std::push_heap(heap.begin(), heap.end(), std::greater<OrderedEvent>());
+    }
+
+    Event pop() {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<OrderedEvent>());
+        Event e = heap.back().event;
+        heap.pop_back();
+        return e;
+    }
+
+    const Event& top() const { return heap.front().event; }
+    bool empty() const { return heap.empty(); }
+    void clear() { heap.clear(); }
+};
+
+/// @brief The links of one partition with their event loop.
+template <class Discipline>
+class TopologyPartition {
+public:
+    struct Link {
+        int id;
+        int next;
+        int nextPartition;  // Partition of the next link, or -1
+        bool remote;        // Next link in another partition
+        double capacity;
+        bool busy = false;
+        double queuedBytes = 0.0;
+        Discipline buffer;
+        AQMStage aqm;
+        RandomSource rng;
+
+        long packetsTransmitted = 0;
+        long packetsDropped = 0;
+        double bytesTransmitted = 0.0;
+        double totalDelay = 0.0;
+        // Links are allocated one after another for all partitions; the
+        // padding keeps neighbours run by different workers off one line
+        char padTail[kCacheLineSize];
+    };
+
+    std::vector<std::unique_ptr<Link>> links;
+    std::vector<int> localIndex;     // Global link ID -> index into links, or -1
+    SourceStatsTable stats;          // Per source, for the packets this partition saw
+    std::vector<SpscChannel<HopMessage>*> outbox; // Per destination partition
+    std::vector<SpscChannel<HopMessage>*> inbox;
+    uint64_t eventsProcessed = 0;
+
+private:
+    double simulationTime = 0.0;
+    double currentTime = 0.0;
+    long nextPacketId = 1;
+    PacketPool pool;
+    OrderedEventQueue eventQueue;
+    std::vector<ArrivalStream> lanes;
+    std::vector<int> laneLink;       // Local link index of each lane
+    std::vector<int> linkOf;         // Per packet handle: local link holding it
+    std::vector<double> bornAt;      // Per packet handle
+    std::vector<HopMessage> pending; // Received, injected at the next window boundary
+
+    void scheduleEvent(const Event& e, uint64_t tie) {
+        if (e.time <= simulationTime) eventQueue.push(e, tie);
+    }
+
+    PacketHandle allocate() {
+        PacketHandle h = pool.allocate();
+        if (h >= linkOf.size()) {
+            linkOf.resize(pool.capacity());
+            bornAt.resize(pool.capacity());
+        }
+        return h;
+    }
+
+    void dropPacket(Link& link, PacketHandle h) {
+        link.packetsDropped++;
+        stats.packetsDropped[pool[h].sourceID]++;
+        pool.release(h);
+    }
+
+    void send(int partition, const HopMessage& m) {
+        SpscChannel<HopMessage>* channel = outbox[partition];
+        // Draining our own inbox while blocked keeps two partitions that
+        // are both full towards each other from deadlocking
+        while (!channel->tryPush(m)) {
+            drainInbox();
+            std::this_thread::yield();
+        }
+    }
+
+    void startNextTransmission(Link& link) {
+        if (link.busy) return;
+
+        while (!link.buffer.empty()) {
+            PacketHandle h = link.buffer.dequeue();
+            const Packet& p = pool[h];
+            link.queuedBytes -= p.size;
+            if (link.aqm.atDequeue() &&
+                link.aqm.shouldDrop(currentTime, currentTime - p.arrivalTime, link.buffer.size(),
+                                    link.queuedBytes, link.rng)) {
+                dropPacket(link, h);
+                continue;
+            }
+
+            link.busy = true;
+            double finish = currentTime + p.size / link.capacity;
+            if (link.remote) {
+                send(link.nextPartition, HopMessage{finish, bornAt[h], p.id, p.sourceID, p.size, link.id, link.next});
+            }
+            scheduleEvent(Event(Event::PACKET_DEPARTURE, finish, h), OrderedEventQueue::departureKey(link.id));
+            return;
+        }
+    }
+
+    void admitPacket(int local, PacketHandle h) {
+        Link& link = *links[local];
+        linkOf[h] = local;
+        if (link.aqm.atEnqueue() &&
+            link.aqm.shouldDrop(currentTime, link.queuedBytes / link.capacity, link.buffer.size(),
+                                link.queuedBytes, link.rng)) {
+            dropPacket(link, h);
+            return;
+        }
+        link.queuedBytes += pool[h].size;
+        link.buffer.enqueue(h, [this, &link](PacketHandle dropped) {
+            link.queuedBytes -= pool[dropped].size;
+            dropPacket(link, dropped);
+        });
+        startNextTransmission(link);
+    }
+
+    void handleArrivalEvent(const Event& e) {
+        int local = laneLink[e.index];
+        Arrival a;
+        if (lanes[e.index].take(links[local]->rng, a)) {
+            scheduleEvent(Event(Event::PACKET_ARRIVAL, lanes[e.index].headTime(), e.index),
+                          OrderedEventQueue::arrivalKey(a.source));
+        }
+        PacketHandle h = allocate();
+        pool[h] = Packet{nextPacketId++, a.source, a.size, currentTime, 0.0};
+        bornAt[h] = currentTime;
+        stats.packetsGenerated[a.source]++;
+        admitPacket(local, h);
+    }
+
+    void handleDepartureEvent(const Event& e) {
+        PacketHandle h = e.index;
+        Link& link = *links[linkOf[h]];
+        Packet& p = pool[h];
+        link.busy = false;
+        link.packetsTransmitted++;
+        link.bytesTransmitted += p.size;
+        link.totalDelay += currentTime - p.arrivalTime;
+
+        if (link.next < 0) {
+            stats.recordDeparture(p.sourceID, p.size, currentTime - bornAt[h]);
+            pool.release(h);
+        } else if (link.remote) {
+            pool.release(h); // Already on its way to the next partition
+        } else {
+            p.arrivalTime = currentTime;
+            admitPacket(localIndex[link.next], h);
+        }
+        startNextTransmission(link);
+    }
+
+public:
+    void configure(const TopologyConfig& topo, const std::vector<int>& members,
+                   const std::vector<int>& partitionOf, int self, const RunOptions& options) {
+        simulationTime = topo.simulationTime;
+        size_t numSources = topo.sources.size();
+        localIndex.assign(topo.links.size(), -1);
+        links.clear();
+
+        Config base;
+        base.numSources = static_cast<int>(numSources);
+        base.simulationTime = simulationTime;
+        base.sources = topo.sources;
+        for (int id : members) {
+            const LinkConfig& lc = topo.links[id];
+            localIndex[id] = static_cast<int>(links.size());
+            links.emplace_back(new Link());
+            Link& link = *links.back();
+            link.id = id;
+            link.next = lc.next;
+            link.nextPartition = lc.next >= 0 ? partitionOf[lc.next] : -1;
+            link.remote = lc.next >= 0 && partitionOf[lc.next] != self;
+            link.capacity = lc.capacity;
+            link.rng.setEngine(options.randomEngine);
+
+            base.linkCapacity = lc.capacity;
+            base.bufferSize = lc.bufferSize;
+            base.bufferBytes = lc.bufferBytes;
+            link.buffer.configure(base, pool);
+            link.aqm.configure(base);
+            link.aqm.select(options.aqm);
+        }
+
+        lanes.clear();
+        laneLink.clear();
+        for (size_t i = 0; i < numSources; ++i) {
+            int local = localIndex[topo.ingress[i]];
+            if (local < 0) continue;
+            const SourceConfig& sc = topo.sources[i];
+            lanes.emplace_back(sc.startFraction * simulationTime, sc.endFraction * simulationTime,
+                               sc.packetRate, static_cast<int>(i), SizeRange{sc.minSize, sc.maxSize});
+            laneLink.push_back(local);
+        }
+        stats.reset(numSources);
+    }
+
+    /// @brief Seeds link l's stream from (seedValue, l), independent of partitioning.
+    void seed(uint64_t seedValue) {
+        for (auto& link : links) link->rng.seed(seedValue * 0x9E3779B97F4A7C15ULL + link->id);
+    }
+
+    /// @brief Clears the run state and primes the arrival lanes.
+    void start() {
+        currentTime = 0.0;
+        nextPacketId = 1;
+        eventsProcessed = 0;
+        eventQueue.clear();
+        pending.clear();
+        pool.reset(0);
+        for (auto& link : links) link->aqm.reset();
+        for (size_t i = 0; i < lanes.size(); ++i) {
+            if (lanes[i].start()) {
+                scheduleEvent(Event(Event::PACKET_ARRIVAL, lanes[i].headTime(), static_cast<uint32_t>(i)),
+                              OrderedEventQueue::arrivalKey(lanes[i].source));
+            }
+        }
+    }
+
+    /// @brief Handles every event earlier than `end`.
+    void processWindow(double end) {
+        while (!eventQueue.empty() && eventQueue.top().time < end) {
+            Event e = eventQueue.pop();
+            currentTime = e.time;
+            if (e.type == Event::PACKET_ARRIVAL) {
+                handleArrivalEvent(e);
+            } else if (e.type == Event::PACKET_DEPARTURE) {
+                handleDepartureEvent(e);
+            } else {
+                admitPacket(linkOf[e.index], e.index); // HOP_ARRIVAL
+            }
+            ++eventsProcessed;
+        }
+    }
+
+    /// @brief Moves everything waiting in the inbound channels to `pending`.
+    void drainInbox() {
+        HopMessage m;
+        for (auto* channel : inbox) {
+            while (channel->tryPop(m)) pending.push_back(m);
+        }
+    }
+
+    /// @brief Injects the received packets as hop arrivals.
+    void injectPending() {
+        for (const HopMessage& m : pending) {
+            if (m.time > simulationTime) continue;
+            PacketHandle h = allocate();
+            pool[h] = Packet{m.id, m.sourceID, m.size, m.time, 0.0};
+            bornAt[h] = m.bornAt;
+            linkOf[h] = localIndex[m.link];
+            eventQueue.push(Event(Event::HOP_ARRIVAL, m.time, h), OrderedEventQueue::hopKey(m.from));
+        }
+        pending.clear();
+    }
+
+    /// @brief Time of the earliest pending event, +infinity if none.
+    double nextEventTime() const {
+        return eventQueue.empty() ? HUGE_VAL : eventQueue.top().time;
+    }
+};
+
+/**
+ * @brief Runs one Discipline on every link of a topology, on up to
+ * `partitions` threads.
+ */
+template <class Discipline>
+class TopologySimulator {
+private:
+    typedef TopologyPartition<Discipline> Partition;
+
+    TopologyConfig topo;
+    RunOptions options;
+    uint64_t seedValue = 1;
+    unsigned requested = 1;
+    double lookaheadTime = HUGE_VAL;
+    uint64_t windowCount = 0;
+
+    std::vector<int> partitionOf; // Per link
+    std::vector<std::unique_ptr<Partition>> parts;
+    std::vector<std::unique_ptr<SpscChannel<HopMessage>>> channels;
+
+    /**
+     * Splits the links into contiguous runs of a post-order walk from the
+     * egress links, so that each partition holds whole subtrees where it
+     * can, balancing the packet rate routed through each partition.
+     */
+    void partition(unsigned count) {
+        size_t n = topo.links.size();
+        std::vector<std::vector<int>> upstream(n);
+        std::vector<int> roots;
+        for (size_t l = 0; l < n; ++l) {
+            if (topo.links[l].next < 0) roots.push_back(static_cast<int>(l));
+            else upstream[topo.links[l].next].push_back(static_cast<int>(l));
+        }
+
+        std::vector<double> load(n, 0.0);
+        for (size_t i = 0; i < topo.sources.size(); ++i) {
+            for (int at = topo.ingress[i]; at >= 0; at = topo.links[at].next) load[at] += topo.sources[i].packetRate;
+        }
+
+        std::vector<int> order;
+        std::vector<std::pair<int, size_t>> stack;
+        for (int root : roots) {
+            stack.push_back(std::make_pair(root, 0));
+            while (!stack.empty()) {
+                std::pair<int, size_t>& top = stack.back();
+                if (top.second < upstream[top.first].size()) {
+                    int child = upstream[top.first][top.second++];
+                    stack.push_back(std::make_pair(child, 0));
+                } else {
+                    order.push_back(top.first);
+                    stack.pop_back();
+                }
+            }
+        }
+
+        double total = 0.0;
+        for (double x : load) total += x + 1e-9; // Idle links still count a little
+        partitionOf.assign(n, 0);
+        double acc = 0.0;
+        unsigned current = 0;
+        for (size_t k = 0; k < order.size(); ++k) {
+            int l = order[k];
+            // Leave at least one link for every later partition
+            bool mustCut = order.size() - k <= count - 1 - current;
+            bool fullEnough = acc >= total * (current + 1) / count;
+            if (current + 1 < count && k > 0 && (mustCut || fullEnough)) ++current;
+            partitionOf[l] = static_cast<int>(current);
+            acc += load[l] + 1e-9;
+        }
+    }
+
+public:
+    void configure(const TopologyConfig& config) {
+        topo = config;
+    }
+
+    void setRunOptions(const RunOptions& runOptions) {
+        options = runOptions;
+    }
+
+    void seed(uint64_t value) {
+        seedValue = value;
+    }
+
+    /// @brief Threads to partition the links over; capped at the link count.
+    void setPartitions(unsigned count) {
+        requested = std::max(1u, count);
+    }
+
+    /**
+     * @brief Executes the simulation. With one partition the event loop runs
+     * to the end on the calling thread without windows.
+     */
+    void run() {
+        unsigned count = static_cast<unsigned>(std::min<size_t>(requested, topo.links.size()));
+        partition(count);
+
+        parts.clear();
+        for (unsigned p = 0; p < count; ++p) {
+            std::vector<int> members;
+            for (size_t l = 0; l < topo.links.size(); ++l) {
+                if (partitionOf[l] == static_cast<int>(p)) members.push_back(static_cast<int>(l));
+            }
+            parts.emplace_back(new Partition());
+            parts.back()->configure(topo, members, partitionOf, static_cast<int>(p), options);
+            parts.back()->seed(seedValue);
+            parts.back()->outbox.assign(count, nullptr);
+        }
+
+        // One channel per partition pair joined by a link, and the lookaheads
+        int minSize = INT_MAX;
+        for (const auto& sc : topo.sources) minSize = std::min(minSize, std::max(1, sc.minSize));
+        std::vector<double> lookahead(count, HUGE_VAL);
+        channels.clear();
+        for (size_t l = 0; l < topo.links.size(); ++l) {
+            int next = topo.links[l].next;
+            if (next < 0 || partitionOf[next] == partitionOf[l]) continue;
+            double& own = lookahead[partitionOf[l]];
+            own = std::min(own, minSize / topo.links[l].capacity);
+            Partition& from = *parts[partitionOf[l]];
+            Partition& to = *parts[partitionOf[next]];
+            if (from.outbox[partitionOf[next]]) continue;
+            channels.emplace_back(new SpscChannel<HopMessage>());
+            from.outbox[partitionOf[next]] = channels.back().get();
+            to.inbox.push_back(channels.back().get());
+        }
+
+        lookaheadTime = *std::min_element(lookahead.begin(), lookahead.end());
+        for (auto& part : parts) part->start();
+        windowCount = 0;
+        if (count == 1) {
+            parts[0]->processWindow(HUGE_VAL);
+            return;
+        }
+
+        std::vector<double> nextTimes(count);
+        for (unsigned p = 0; p < count; ++p) nextTimes[p] = parts[p]->nextEventTime();
+        double simulationTime = topo.simulationTime;
+        if (*std::min_element(nextTimes.begin(), nextTimes.end()) > simulationTime) return;
+
+        // Earliest time a message sent from now on could be stamped with
+        auto horizon = [&] {
+            double end = HUGE_VAL;
+            for (unsigned p = 0; p < count; ++p) end = std::min(end, nextTimes[p] + lookahead[p]);
+            return end;
+        };
+
+        SpinBarrier barrier(count);
+        std::vector<uint64_t> windows(count, 0);
+        double firstEnd = horizon();
+
+        auto worker = [&](unsigned p) {
+            Partition& part = *parts[p];
+            double windowEnd = firstEnd;
+            for (;;) {
+                part.processWindow(windowEnd);
+                ++windows[p];
+                barrier.wait([&part] { part.drainInbox(); });
+
+                // Every message of the window is in a channel by now
+                part.drainInbox();
+                part.injectPending();
+                nextTimes[p] = part.nextEventTime();
+                barrier.wait();
+
+                if (*std::min_element(nextTimes.begin(), nextTimes.end()) > simulationTime) return;
+                windowEnd = horizon();
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned p = 1; p < count; ++p) threads.emplace_back(worker, p);
+        worker(0);
+        for (auto& t : threads) t.join();
+        windowCount = windows[0];
+    }
+
+    /// @brief Partitions used by the last run().
+    size_t partitions() const { return parts.size(); }
+
+    /// @brief Synchronization windows of the last run() (0 when sequential).
+    uint64_t windows() const { return windowCount; }
+
+    /// @brief Smallest partition lookahead of the last run(); +infinity if no
+    /// link crossed partitions.
+    double lookahead() const { return lookaheadTime; }
+
+    uint64_t eventCount() const {
+        uint64_t n = 0;
+        for (const auto& part : parts) n += part->eventsProcessed;
+        return n;
+    }
+
+    /**
+     * @brief Calculates the per-link and end-to-end metrics of the last run.
+     */
+    TopologyMetrics metrics() const {
+        TopologyMetrics m;
+        double simulationTime = topo.simulationTime;
+
+        m.links.resize(topo.links.size());
+        for (const auto& part : parts) {
+            for (const auto& link : part->links) {
+                LinkMetrics& lm = m.links[link->id];
+                lm.next = link->next;
+                lm.capacity = link->capacity;
+                lm.packetsTransmitted = link->packetsTransmitted;
+                lm.packetsDropped = link->packetsDropped;
+                lm.utilization = (link->bytesTransmitted / link->capacity) / simulationTime;
+                lm.avgDelay = link->packetsTransmitted > 0 ? link->totalDelay / link->packetsTransmitted : 0.0;
+            }
+        }
+
+        size_t n = topo.sources.size();
+        SourceStatsTable s;
+        s.reset(n);
+        for (const auto& part : parts) s.add(part->stats);
+
+        SourceStatsTable::Array<double> weights;
+        LogHistogram allDelays;
+        m.sources.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            allDelays.merge(s.delays[i]);
+            weights.push_back(topo.sources[i].weight);
+
+            SourceMetrics sm;
+            sm.weight = topo.sources[i].weight;
+            sm.packetsGenerated = s.packetsGenerated[i];
+            sm.packetsTransmitted = s.packetsTransmitted[i];
+            sm.packetsDropped = s.packetsDropped[i];
+            sm.dropRate = sm.packetsGenerated > 0 ? (double)sm.packetsDropped / sm.packetsGenerated : 0.0;
+            sm.avgDelay = sm.packetsTransmitted > 0 ? s.totalDelay[i] / sm.packetsTransmitted : 0.0;
+            sm.delayP50 = s.delays[i].quantile(0.5);
+            sm.delayP99 = s.delays[i].quantile(0.99);
+            sm.delayP999 = s.delays[i].quantile(0.999);
+            sm.throughput = s.bytesTransmitted[i] / simulationTime;
+            m.sources.push_back(sm);
+        }
+
+        StatsTotals t = s.totals();
+        m.avgDelay = t.packetsTransmitted > 0 ? t.totalDelay / t.packetsTransmitted : 0.0;
+        m.dropProbability = t.packetsGenerated > 0 ? (double)t.packetsDropped / t.packetsGenerated : 0.0;
+        m.fairness = s.fairness(Discipline::weightedFairness ? weights.data() : nullptr);
+        m.delayP50 = allDelays.quantile(0.5);
+        m.delayP99 = allDelays.quantile(0.99);
+        m.delayP999 = allDelays.quantile(0.999);
+        return m;
+    }
+
+    /**
+     * @brief Calculates metrics and outputs them to the provided stream.
+     */
+    void printResults(std::ostream& out) const {
+        TopologyMetrics m = metrics();
+
+        out << std::fixed << std::setprecision(6);
+        out << "## End-to-End Performance Metrics (" << Discipline::name() << ", "
+            << topo.links.size() << " links)\n"
+            << "1. Avg. Packet Delay:    " << m.avgDelay << " s\n"
+            << "2. Packet Drop Prob.:    " << m.dropProbability << "\n"
+            << "3. Fairness Index:       " << m.fairness << "\n"
+            << "4. Delay p50:            " << m.delayP50 << " s\n"
+            << "5. Delay p99:            " << m.delayP99 << " s\n"
+            << "6. Delay p99.9:          " << m.delayP999 << " s\n\n";
+
+        out << "## Per-Link Statistics\n"
+            << "------------------------------------------------------------------------------------\n"
+            << "Link | Next | Capacity (B/s) | Trans'd Pkts | Drop'd Pkts | Utilization | Avg Delay (s)\n"
+            << "------------------------------------------------------------------------------------\n";
+        for (size_t l = 0; l < m.links.size(); ++l) {
+            const LinkMetrics& lm = m.links[l];
+            out << std::setw(4) << l << " | "
+                << std::setw(4) << lm.next << " | "
+                << std::setw(14) << std::setprecision(2) << lm.capacity << " | "
+                << std::setw(12) << lm.packetsTransmitted << " | "
+                << std::setw(11) << lm.packetsDropped << " | "
+                << std::setw(11) << std::setprecision(6) << lm.utilization << " | "
+                << std::setw(13) << lm.avgDelay << "\n";
+        }
+        out << "------------------------------------------------------------------------------------\n";
+
+        out << "\n## Per-Source Statistics (end to end)\n"
+            << "----------------------------------------------------------------------------------------------\n"
+            << "Src | Link | Weight | Gen'd Pkts | Deliv'd Pkts | Drop'd Pkts | Drop Rate | Avg Delay (s) | Thruput (B/s)\n"
+            << "----------------------------------------------------------------------------------------------\n";
+        for (size_t i = 0; i < m.sources.size(); ++i) {
+            const SourceMetrics& sm = m.sources[i];
+            out << std::setw(3) << i << " | "
+                << std::setw(4) << topo.ingress[i] << " | "
+                << std::setw(6) << std::setprecision(2) << sm.weight << " | "
+                << std::setw(10) << sm.packetsGenerated << " | "
+                << std::setw(12) << sm.packetsTransmitted << " | "
+                << std::setw(11) << sm.packetsDropped << " | "
+                << std::setw(9) << std::setprecision(4) << sm.dropRate << " | "
+                << std::setw(13) << std::setprecision(6) << sm.avgDelay << " | "
+                << std::setw(13) << std::setprecision(2) << sm.throughput << "\n";
+        }
+        out << "----------------------------------------------------------------------------------------------\n";
+    }
+};
+
+#endif // SIM_TOPOLOGY_H
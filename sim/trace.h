@@ -0,0 +1,207 @@
+/**
+ * @file trace.h
+ * @brief Per-packet binary trace: a background-thread writer and an mmap reader.
+ * The file is a 32-byte TraceHeader followed by fixed 40-byte TraceRecords,
+ * one per arrival, drop and departure, in simulation time order. At roughly
+ * two records per packet a 100M-packet run is about 8 GB.
+ *
+ * TraceWriter fills a record block in the simulation thread and hands full
+ * blocks to a writer thread through a small ring, so the event loop only
+ * waits if the disk falls a whole ring behind.
+ */
+
+#ifndef SIM_TRACE_H
+#define SIM_TRACE_H
+
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdexcept>
+
+#include "packet_pool.h"
+#include "mapped_file.h"
+
+/// @brief File header; recordCount is filled in when the writer closes.
+struct TraceHeader {
+    char magic[8];        // "PKTTRACE"
+    uint32_t version;
+    uint32_t recordSize;  // sizeof(TraceRecord)
+    uint64_t recordCount;
+    uint64_t reserved;
+};
+
+/// @brief One trace entry.
+struct TraceRecord {
+    enum Type : uint8_t { ARRIVAL = 0, DROP = 1, DEPARTURE = 2 };
+    static const uint32_t kMaxSize = 0xFFFFFFu; // Largest size the 24-bit field holds
+
+    double time;              // When the arrival, drop or departure happened
+    double arrivalTime;       // When the packet entered the system
+    double virtualFinishTime; // Scheduling tag; 0 on ARRIVAL, as tags are assigned on admission
+    uint64_t packetId;
+    uint32_t sourceID;
+    uint32_t sizeAndType;     // Size in bytes (low 24 bits) | Type << 24
+
+    uint32_t size() const { return sizeAndType & 0xFFFFFFu; }
+    Type type() const { return static_cast<Type>(sizeAndType >> 24); }
+};
+
+static_assert(sizeof(TraceHeader) == 32, "TraceHeader layout is part of the file format");
+static_assert(sizeof(TraceRecord) == 40, "TraceRecord layout is part of the file format");
+
+static const char kTraceMagic[8] = {'P', 'K', 'T', 'T', 'R', 'A', 'C', 'E'};
+static const uint32_t kTraceVersion = 1;
+
+/// @brief Streams TraceRecords to a file from a background thread.
+class TraceWriter {
+private:
+    static const size_t kBlockRecords = 1 << 15; // 1.25 MB per block
+    static const size_t kRingBlocks = 4;
+
+    std::FILE* file = nullptr;
+    std::vector<std::vector<TraceRecord>> ring;
+    std::vector<size_t> filled; // Records used in each ring block
+    size_t current = 0;         // Block being filled by the simulation thread
+    size_t position = 0;
+    size_t pending = 0;         // Full blocks waiting for the writer
+    size_t nextToWrite = 0;
+    uint64_t written = 0;
+    bool closing = false;
+    bool ioError = false;
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable blockReady;
+    std::condition_variable blockFree;
+
+    void writerLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            blockReady.wait(lock, [this] { return pending > 0 || closing; });
+            if (pending == 0 && closing) return;
+
+            size_t block = nextToWrite;
+            size_t count = filled[block];
+            lock.unlock();
+            if (std::fwrite(ring[block].data(), sizeof(TraceRecord), count, file) != count) ioError = true;
+            lock.lock();
+
+            written += count;
+            nextToWrite = (nextToWrite + 1) % kRingBlocks;
+            --pending;
+            blockFree.notify_one();
+        }
+    }
+
+    void submitBlock() {
+        std::unique_lock<std::mutex> lock(mutex);
+        filled[current] = position;
+        ++pending;
+        blockReady.notify_one();
+        // Wait only if every block is still queued for the writer
+        blockFree.wait(lock, [this] { return pending < kRingBlocks; });
+        current = (current + 1) % kRingBlocks;
+        position = 0;
+    }
+
+public:
+    TraceWriter() = default;
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+    ~TraceWriter() {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+
+    void open(const std::string& path) {
+        file = std::fopen(path.c_str(), "wb");
+        if (!file) throw std::runtime_error("Could not create trace file: " + path);
+
+        TraceHeader header;
+        std::memcpy(header.magic, kTraceMagic, sizeof(header.magic));
+        header.version = kTraceVersion;
+        header.recordSize = sizeof(TraceRecord);
+        header.recordCount = 0;
+        header.reserved = 0;
+        std::fwrite(&header, sizeof(header), 1, file);
+
+        ring.assign(kRingBlocks, std::vector<TraceRecord>(kBlockRecords));
+        filled.assign(kRingBlocks, 0);
+        current = position = pending = nextToWrite = 0;
+        written = 0;
+        closing = ioError = false;
+        worker = std::thread(&TraceWriter::writerLoop, this);
+    }
+
+    bool isOpen() const { return file != nullptr; }
+
+    void record(TraceRecord::Type type, double time, const Packet& p) {
+        TraceRecord& r = ring[current][position];
+        r.time = time;
+        r.arrivalTime = p.arrivalTime;
+        r.virtualFinishTime = p.virtualFinishTime;
+        r.packetId = static_cast<uint64_t>(p.id);
+        r.sourceID = static_cast<uint32_t>(p.sourceID);
+        if (static_cast<uint32_t>(p.size) > TraceRecord::kMaxSize) {
+            throw std::runtime_error("Packet of " + std::to_string(p.size) + " bytes is too large for the trace");
+        }
+        r.sizeAndType = static_cast<uint32_t>(p.size) | (static_cast<uint32_t>(type) << 24);
+        if (++position == kBlockRecords) submitBlock();
+    }
+
+    /// @brief Flushes all records, patches the header count and closes the file.
+    void close() {
+        if (!file) return;
+        if (position > 0) submitBlock();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closing = true;
+        }
+        blockReady.notify_one();
+        worker.join();
+
+        std::fseek(file, offsetof(TraceHeader, recordCount), SEEK_SET);
+        std::fwrite(&written, sizeof(written), 1, file);
+        bool failed = ioError || std::fclose(file) != 0;
+        file = nullptr;
+        ring.clear();
+        if (failed) throw std::runtime_error("Error while writing trace file");
+    }
+};
+
+/// @brief Read-only memory-mapped view of a trace file.
+class TraceReader {
+private:
+    MappedFile file;
+    const TraceRecord* first = nullptr;
+    size_t count = 0;
+
+public:
+    explicit TraceReader(const std::string& path) : file(path) {
+        if (file.size() < sizeof(TraceHeader)) throw std::runtime_error("Trace file is truncated: " + path);
+
+        const TraceHeader* header = reinterpret_cast<const TraceHeader*>(file.data());
+        if (std::memcmp(header->magic, kTraceMagic, sizeof(kTraceMagic)) != 0 ||
+            header->version != kTraceVersion || header->recordSize != sizeof(TraceRecord)) {
+            throw std::runtime_error("Not a version " + std::to_string(kTraceVersion) + " packet trace: " + path);
+        }
+        size_t available = (file.size() - sizeof(TraceHeader)) / sizeof(TraceRecord);
+        count = header->recordCount < available ? static_cast<size_t>(header->recordCount) : available;
+        first = reinterpret_cast<const TraceRecord*>(file.data() + sizeof(TraceHeader));
+    }
+
+    size_t size() const { return count; }
+    const TraceRecord& operator[](size_t i) const { return first[i]; }
+    const TraceRecord* begin() const { return first; }
+    const TraceRecord* end() const { return first + count; }
+};
+
+#endif // SIM_TRACE_H
@@ -0,0 +1,389 @@
+/**
+ * @file wfq.h
+ * @brief Weighted Fair Queuing (WFQ) scheduling discipline.
+ * Uses virtual finish times (VFT) to approximate Generalized Processor Sharing (GPS).
+ * Drop Policy: Drops the packet with the smallest VFT when the buffer is full.
+ * With a byte limit, as many smallest-VFT packets as needed are evicted to
+ * make room for the arrival, and one larger than the whole limit is dropped.
+ *
+ * The system virtual time is a policy. GPSVirtualClock emulates the fluid
+ * GPS reference system (Parekh & Gallager): V(t) advances at C / W(t), where
+ * W is the weight sum of GPS-backlogged sources, and a source leaves the
+ * backlogged set when V reaches its last finish tag. Those breakpoints come
+ * off a heap of finish tags as the clock is advanced lazily to each arrival,
+ * so the cost is O(log n) per packet. The reference system is fed every
+ * arrival, including packets the finite buffer later evicts.
+ * LegacyVirtualClock keeps the original rule of setting V to the start tag
+ * of the packet being sent.
+ *
+ * FlowWFQDiscipline is the same scheduler for flow mode (flows.h), where
+ * flows come and go by the million. A flow's last finish tag only matters
+ * while it is ahead of V, i.e. while the flow is GPS-backlogged, so
+ * SparseGPSVirtualClock keeps tags for those flows alone, in a FlowMap, and
+ * forgets a flow at the breakpoint where V catches up with it.
+ */
+
+#ifndef SIM_WFQ_H
+#define SIM_WFQ_H
+
+#include <vector>
+#include <algorithm>
+
+#include "simulator.h"
+#include "flow_buffer.h"
+#include "indexed_heap.h"
+#include "flow_map.h"
+
+/// @brief Virtual time of the emulated GPS fluid system.
+class GPSVirtualClock {
+private:
+    double capacity = 0.0;     // Bytes per second
+    double virtualTime = 0.0;
+    double lastUpdate = 0.0;   // Real time V was last advanced to
+    double activeWeight = 0.0; // W: sum of weights of GPS-backlogged sources
+    std::vector<double> weights;
+    IndexedMinHeap backlogged; // GPS-backlogged sources keyed by their last finish tag
+
+public:
+    static const char* name() { return "WFQ"; }
+
+    void configure(const Config& config) {
+        capacity = config.linkCapacity;
+        virtualTime = lastUpdate = activeWeight = 0.0;
+        weights.clear();
+        for (const auto& sc : config.sources) weights.push_back(sc.weight);
+        backlogged.reset(config.sources.size());
+    }
+
+    /// @brief Advances V to real time `now` and returns it.
+    double at(double now) {
+        while (!backlogged.empty()) {
+            // Real time at which V reaches the earliest GPS finish tag
+            double breakpoint = lastUpdate + (backlogged.topKey() - virtualTime) * activeWeight / capacity;
+            if (breakpoint > now) {
+                virtualTime += (now - lastUpdate) * capacity / activeWeight;
+                break;
+            }
+            virtualTime = backlogged.topKey();
+            lastUpdate = breakpoint;
+            activeWeight -= weights[backlogged.top()];
+            backlogged.pop();
+        }
+        // Rebuild from zero when GPS idles so rounding cannot accumulate
+        if (backlogged.empty()) activeWeight = 0.0;
+        lastUpdate = now;
+        return virtualTime;
+    }
+
+    /// @brief Records that source `src` now finishes at `finishTag` in GPS.
+    void tagged(uint32_t src, double finishTag) {
+        if (!(weights[src] > 0)) return; // A weightless source never runs in GPS
+        if (backlogged.contains(src)) {
+            backlogged.update(src, finishTag);
+        } else {
+            backlogged.push(src, finishTag);
+            activeWeight += weights[src];
+        }
+    }
+
+    void serving(const Packet&, double) {}
+
+    void saveState(StateWriter& out) const {
+        out.put(virtualTime, lastUpdate, activeWeight);
+        backlogged.saveState(out);
+    }
+
+    void loadState(StateReader& in) {
+        in.get(virtualTime, lastUpdate, activeWeight);
+        backlogged.loadState(in);
+    }
+};
+
+/// @brief The original approximation: V is the start tag of the packet being sent.
+class LegacyVirtualClock {
+private:
+    double virtualTime = 0.0;
+
+public:
+    static const char* name() { return "WFQ-legacy"; }
+
+    void configure(const Config&) { virtualTime = 0.0; }
+    double at(double) const { return virtualTime; }
+    void tagged(uint32_t, double) {}
+
+    void serving(const Packet& p, double weight) {
+        virtualTime = p.virtualFinishTime - (p.size / weight);
+    }
+
+    void saveState(StateWriter& out) const { out.put(virtualTime); }
+    void loadState(StateReader& in) { in.get(virtualTime); }
+};
+
+/// @brief VFT-ordered buffer plus the per-source WFQ state.
+template <class VirtualClock>
+class BasicWFQDiscipline {
+private:
+    size_t bufferSize = 0;
+    double byteLimit = 0.0;
+    std::vector<double> weights;
+    std::vector<double> lastFinishTime; // Tracks F_{k-1} for each source
+    PacketPool* pool = nullptr;
+    VirtualClock clock;
+
+    // WFQ Buffer: per-source FIFOs served in Virtual Finish Time order
+    TaggedFlowBuffer packetBuffer;
+
+public:
+    static const char* name() { return VirtualClock::name(); }
+    static const bool weightedFairness = true;
+
+    void configure(const Config& config, PacketPool& packetPool) {
+        pool = &packetPool;
+        bufferSize = config.bufferSize;
+        byteLimit = bufferByteLimit(config);
+        weights.clear();
+        for (const auto& sc : config.sources) weights.push_back(sc.weight);
+        lastFinishTime.assign(config.sources.size(), 0.0);
+        clock.configure(config);
+        packetBuffer.reset(config.sources.size(), packetPool);
+    }
+
+    bool empty() const { return packetBuffer.empty(); }
+    size_t size() const { return packetBuffer.size(); }
+
+    template <class OnDrop>
+    void enqueue(PacketHandle h, OnDrop onDrop) {
+        Packet& p = (*pool)[h];
+
+        // --- WFQ Core Logic: Calculate VFT ---
+        double weight = weights[p.sourceID];
+        double virtualStartTime = std::max(clock.at(p.arrivalTime), lastFinishTime[p.sourceID]);
+        p.virtualFinishTime = virtualStartTime + (p.size / weight);
+        lastFinishTime[p.sourceID] = p.virtualFinishTime;
+        clock.tagged(static_cast<uint32_t>(p.sourceID), p.virtualFinishTime);
+
+        // Buffer management (Drop packets with smallest VFT if full)
+        if (p.size > byteLimit) {
+            onDrop(h);
+            return;
+        }
+        double excess = packetBuffer.byteCount() + p.size - byteLimit;
+        if (excess > 0) packetBuffer.evictBytes(excess, onDrop);
+
+        if (packetBuffer.size() < bufferSize) {
+            packetBuffer.push(h);
+        } else if (bufferSize > 0) {
+            // Drop policy: evict the smallest VFT and admit the new packet in one step
+            onDrop(packetBuffer.replaceTop(h));
+        } else {
+            onDrop(h);
+        }
+    }
+
+    PacketHandle dequeue() {
+        PacketHandle h = packetBuffer.pop();
+        const Packet& p = (*pool)[h];
+        clock.serving(p, weights[p.sourceID]);
+        return h;
+    }
+
+    void saveState(StateWriter& out) const {
+        out.putVector(lastFinishTime);
+        clock.saveState(out);
+        packetBuffer.saveState(out);
+    }
+
+    void loadState(StateReader& in) {
+        in.getVector(lastFinishTime, weights.size());
+        clock.loadState(in);
+        packetBuffer.loadState(in);
+    }
+};
+
+/**
+ * @brief GPSVirtualClock over flow IDs, holding state only for backlogged
+ * flows. The breakpoint heap is keyed by finish tags that may have been
+ * superseded: an entry is pushed back with the current tag when V reaches a
+ * stale one. Dropped packets are taken back out of the fluid system with
+ * released(), so the GPS reference carries only admitted work and keeps
+ * pace with the buffer under overload. Lowering a tag pushes a second
+ * entry for the flow; entries left over from a flow that has since left
+ * the fluid system carry an old epoch and are discarded when they surface.
+ */
+class SparseGPSVirtualClock {
+private:
+    struct FlowTag {
+        double lastFinish = 0.0;
+        double weight = 0.0;
+        uint32_t epoch = 0; // Matches the flow's live heap entries
+    };
+
+    struct Breakpoint {
+        double tag;
+        uint32_t flow;
+        uint32_t epoch;
+
+        bool operator>(const Breakpoint& other) const { return tag > other.tag; }
+    };
+
+    double capacity = 0.0;
+    double virtualTime = 0.0;
+    double lastUpdate = 0.0;
+    double activeWeight = 0.0;
+    uint32_t epochs = 0;
+    FlowMap<FlowTag> backlogged;
+    std::vector<Breakpoint> heap;
+
+    void push(double tag, uint32_t flow, uint32_t epoch) {
+        heap.push_back(Breakpoint{tag, flow, epoch});
+        std::push_heap(heap.begin(), heap.end(), std::greater<Breakpoint>());
+    }
+
+    void leave(uint32_t flow, const FlowTag& t) {
+        activeWeight -= t.weight;
+        backlogged.erase(flow);
+    }
+
+public:
+    void configure(const Config& config) {
+        capacity = config.linkCapacity;
+        virtualTime = lastUpdate = activeWeight = 0.0;
+        epochs = 0;
+        backlogged.clear();
+        heap.clear();
+    }
+
+    double at(double now) {
+        // With no flow backlogged only stale entries remain, and GPS idles
+        while (!heap.empty() && backlogged.size() > 0) {
+            double breakpoint = lastUpdate + (heap.front().tag - virtualTime) * activeWeight / capacity;
+            if (breakpoint > now) {
+                virtualTime += (now - lastUpdate) * capacity / activeWeight;
+                break;
+            }
+            virtualTime = heap.front().tag;
+            lastUpdate = breakpoint;
+            std::pop_heap(heap.begin(), heap.end(), std::greater<Breakpoint>());
+            Breakpoint e = heap.back();
+            heap.pop_back();
+            FlowTag* t = backlogged.find(e.flow);
+            if (!t || t->epoch != e.epoch) continue;
+            if (t->lastFinish > virtualTime) {
+                push(t->lastFinish, e.flow, e.epoch);
+            } else {
+                leave(e.flow, *t);
+            }
+        }
+        if (backlogged.size() == 0) {
+            activeWeight = 0.0;
+            heap.clear();
+        }
+        lastUpdate = now;
+        return virtualTime;
+    }
+
+    /// @brief F_{k-1} of `flow`, or 0 once V has passed it.
+    double lastFinish(uint32_t flow) const {
+        const FlowTag* t = backlogged.find(flow);
+        return t ? t->lastFinish : 0.0;
+    }
+
+    void tagged(uint32_t flow, double weight, double finishTag) {
+        if (!(weight > 0)) return;
+        FlowTag* t = backlogged.find(flow);
+        if (t) {
+            t->lastFinish = finishTag;
+            return;
+        }
+        FlowTag& added = backlogged.insert(flow);
+        added.lastFinish = finishTag;
+        added.weight = weight;
+        added.epoch = ++epochs;
+        push(finishTag, flow, added.epoch);
+        activeWeight += weight;
+    }
+
+    /// @brief Withdraws a dropped packet's work from `flow`; call after at() for the current time.
+    void released(uint32_t flow, int size) {
+        FlowTag* t = backlogged.find(flow);
+        if (!t) return;
+        t->lastFinish = std::max(virtualTime, t->lastFinish - size / t->weight);
+        if (t->lastFinish > virtualTime) {
+            push(t->lastFinish, flow, t->epoch);
+        } else {
+            leave(flow, *t);
+        }
+    }
+
+    size_t trackedFlows() const { return backlogged.size(); }
+    size_t memoryBytes() const { return backlogged.memoryBytes() + heap.capacity() * sizeof(Breakpoint); }
+};
+
+/**
+ * @brief WFQ for flow mode: Packet::sourceID is the flow ID, the flow's
+ * weight comes with each packet and the buffer keeps no per-flow state.
+ */
+class FlowWFQDiscipline {
+private:
+    size_t bufferSize = 0;
+    double byteLimit = 0.0;
+    PacketPool* pool = nullptr;
+    SparseGPSVirtualClock clock;
+    TaggedPacketHeap packetBuffer;
+
+public:
+    static const char* name() { return "WFQ"; }
+    static const bool weightedFairness = true;
+
+    void configure(const Config& config, PacketPool& packetPool) {
+        pool = &packetPool;
+        bufferSize = config.bufferSize;
+        byteLimit = bufferByteLimit(config);
+        clock.configure(config);
+        packetBuffer.reset(packetPool);
+    }
+
+    bool empty() const { return packetBuffer.empty(); }
+    size_t size() const { return packetBuffer.size(); }
+
+    template <class OnDrop>
+    void enqueue(PacketHandle h, double weight, OnDrop onDrop) {
+        Packet& p = (*pool)[h];
+        uint32_t flow = static_cast<uint32_t>(p.sourceID);
+        double virtualNow = clock.at(p.arrivalTime);
+        if (p.size > byteLimit || bufferSize == 0) {
+            onDrop(h); // Never admitted, so never tagged
+            return;
+        }
+        double virtualStartTime = std::max(virtualNow, clock.lastFinish(flow));
+        p.virtualFinishTime = virtualStartTime + (p.size / weight);
+        clock.tagged(flow, weight, p.virtualFinishTime);
+
+        // Same buffer management as BasicWFQDiscipline
+        auto drop = [this, &onDrop](PacketHandle dropped) {
+            const Packet& d = (*pool)[dropped];
+            clock.released(static_cast<uint32_t>(d.sourceID), d.size);
+            onDrop(dropped);
+        };
+        double excess = packetBuffer.byteCount() + p.size - byteLimit;
+        if (excess > 0) packetBuffer.evictBytes(excess, drop);
+
+        if (packetBuffer.size() < bufferSize) {
+            packetBuffer.push(h);
+        } else {
+            drop(packetBuffer.replaceTop(h));
+        }
+    }
+
+    PacketHandle dequeue() { return packetBuffer.pop(); }
+
+    /// @brief Flows whose finish tag is held, and the bytes holding them.
+    size_t trackedFlows() const { return clock.trackedFlows(); }
+    size_t trackedBytes() const { return clock.memoryBytes(); }
+};
+
+typedef BasicWFQDiscipline<GPSVirtualClock> WFQDiscipline;
+typedef BasicWFQDiscipline<LegacyVirtualClock> LegacyWFQDiscipline;
+typedef Simulator<WFQDiscipline> WFQSimulator;
+
+#endif // SIM_WFQ_H
@@ -0,0 +1,744 @@
+/**
+ * @file simulator.cpp
+ * @brief Command-line driver for the packet scheduler simulations.
+ * Selects a scheduling discipline and event-queue backend, runs one
+ * simulation of the given input file, and writes the report to both a file
+ * and the console.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#include <iterator>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+#include "sim/fcfs.h"
+#include "sim/wfq.h"
+#include "sim/drr.h"
+#include "sim/sfq.h"
+#include "sim/replications.h"
+#include "sim/sweep.h"
+#include "sim/topology.h"
+#include "sim/rare_event.h"
+#include "sim/analytic.h"
+#include "sim/flows.h"
+#include "sim/export.h"
+
+/// @brief Parsed command-line options.
+struct Options {
+    std::string scheduler;
+    std::string inputFilename;
+    std::string eventQueue = "binary";
+    bool eventQueueSet = false; // --event-queue given; a restore otherwise takes the snapshot's
+    RunOptions run;
+    size_t replications = 0; // 0 = single run with the default seed
+    unsigned threads = 1;
+    uint64_t seed = 1;
+    std::vector<std::string> sweepAxes;
+    std::string sweepFormat = "csv";
+    std::string sweepOutput;
+    std::string traceFile;
+    std::string metricsOutput;
+    std::string replayFile;
+    size_t replayLookahead = 4096;
+    bool topology = false;      // Input is a topology file
+    long long bufferBytes = -1; // Overrides the input file's byte limit when >= 0
+    double checkpointAt = -1.0; // Snapshot time of a single run when >= 0
+    std::string checkpointOutput;
+    std::string restoreFile;
+    bool seedSet = false;        // --seed given; a restored run is reseeded with it
+    bool runOptionsSet = false;  // A flag that shapes RunOptions was given
+    size_t rareEventCycles = 0;  // > 0 selects the importance-sampling estimator
+    double rareEventTwist = 0.0;
+    bool analytic = false;       // Closed-form M/G/1/K estimates instead of a simulation
+    std::string prescreen;       // Analytic bounds a sweep point must meet to be simulated
+    bool controlVariate = false; // Adjust replication means with the arrival count
+    bool flows = false;          // Source lines are flow classes, run by the flow engine
+    std::string exportFormat;    // json or csv; empty disables the structured export
+    std::string exportOutput;
+};
+
+static void printUsage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [options] <fcfs|wfq|wfq-legacy|drr|sfq> <input_file>\n"
+              << "Options:\n"
+              << "  --event-queue <binary|dary|calendar|ladder>   Future event list backend (default: binary)\n"
+              << "  --aggregate-arrivals                          One superposed Poisson stream per activity window\n"
+              << "  --rng <xoshiro|pcg|minstd>                    Random engine (default: xoshiro)\n"
+              << "  --seed <S>                                    Seed; replications derive theirs from it (default: 1)\n"
+              << "  --replications <N>                            Run N independently seeded replications\n"
+              << "  --threads <T>                                 Worker threads for replications or topology partitions (default: 1)\n"
+              << "  --topology                                    Input is a multi-link topology file (single runs only)\n"
+              << "  --flows                                       Source lines are flow classes; run millions of flows (fcfs, wfq)\n"
+              << "  --buffer-bytes <B>                            Byte limit on the buffer, 0 for none (default: from the input)\n"
+              << "  --sweep <param>=<v1>,<v2>,...                 Sweep buffer, buffer_bytes, capacity or weight.<src>; repeat for a grid\n"
+              << "  --sweep-format <csv|json>                     Sweep table format (default: csv)\n"
+              << "  --sweep-out <file>                            Sweep table path (default: <scheduler>_sweep_<input>.<format>)\n"
+              << "  --trace <file>                                Write a binary per-packet trace (single runs only)\n"
+              << "  --replay <file>                               Drive arrivals from a trace: packet trace, arrival file, pcap or CSV\n"
+              << "  --replay-lookahead <N>                        Arrivals held for reordering the replay (default: 4096)\n"
+              << "  --metrics-window <seconds>                    Sample a metrics time series (single runs only)\n"
+              << "  --metrics-capacity <N>                        Windows retained, newest kept (default: 4096)\n"
+              << "  --metrics-out <file>                          Time-series path (default: <scheduler>_timeseries_<input>.csv)\n"
+              << "  --aqm <none|red|codel|pie>[:key=value,...]    Early-drop stage, e.g. red:min=5,max=15,p=0.1 (default: none)\n"
+              << "  --aqm-point <enqueue|dequeue>                 Where the stage decides (default: dequeue for codel, else enqueue)\n"
+              << "  --warmup <seconds|auto>                       Discard statistics before this time, or detect it with MSER-5\n"
+              << "  --precision <fraction>                        Stop once the mean delay's 95% CI is within this fraction of it\n"
+              << "  --analytic                                    Print closed-form M/G/1/K estimates instead of simulating (fcfs)\n"
+              << "  --prescreen <bound>=<v>,...                   Simulate only sweep points whose M/G/1/K estimate meets\n"
+              << "                                                max_drop, max_delay and min_utilization (fcfs)\n"
+              << "  --control-variate                             Reduce replication variance with the arrival count\n"
+              << "  --rare-event <cycles>                         Estimate a tiny FCFS drop probability by importance sampling\n"
+              << "  --rare-event-twist <factor>                   Twisted / actual arrival rate (default: (mu/lambda)^2)\n"
+              << "  --export <json|csv>                           Also stream results as JSON Lines or per-table CSV\n"
+              << "  --export-out <file>                           Export path (default: <scheduler>_results_<input>.<jsonl|csv>)\n"
+              << "  --checkpoint-at <seconds>                     Snapshot the run at this time, then finish it (single runs only)\n"
+              << "  --checkpoint-out <file>                       Snapshot path (default: <scheduler>_checkpoint_<input>.bin)\n"
+              << "  --restore <file>                              Continue a snapshot of this input; --seed branches it\n";
+}
+
+static unsigned long long parseCount(const std::string& arg, const char* value) {
+    try {
+        size_t used = 0;
+        unsigned long long n = std::stoull(value, &used);
+        if (value[used] == '\0') return n;
+    } catch (const std::exception&) {
+    }
+    throw std::invalid_argument("Invalid value for " + arg + ": " + value);
+}
+
+static double parsePositive(const std::string& arg, const char* value) {
+    try {
+        size_t used = 0;
+        double x = std::stod(value, &used);
+        if (value[used] == '\0' && x > 0.0) return x;
+    } catch (const std::exception&) {
+    }
+    throw std::invalid_argument("Invalid value for " + arg + ": " + value);
+}
+
+static double parseTime(const std::string& arg, const char* value) {
+    try {
+        size_t used = 0;
+        double x = std::stod(value, &used);
+        if (value[used] == '\0' && x >= 0.0) return x;
+    } catch (const std::exception&) {
+    }
+    throw std::invalid_argument("Invalid value for " + arg + ": " + value);
+}
+
+static Options parseOptions(int argc, char* argv[]) {
+    Options opt;
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool takesValue = (arg == "--event-queue" || arg == "--rng" || arg == "--replications" ||
+                           arg == "--threads" || arg == "--seed" || arg == "--sweep" ||
+                           arg == "--sweep-format" || arg == "--sweep-out" || arg == "--trace" ||
+                           arg == "--metrics-window" || arg == "--metrics-capacity" || arg == "--metrics-out" ||
+                           arg == "--replay" || arg == "--replay-lookahead" || arg == "--aqm" ||
+                           arg == "--aqm-point" || arg == "--buffer-bytes" || arg == "--checkpoint-at" ||
+                           arg == "--checkpoint-out" || arg == "--restore" || arg == "--warmup" ||
+                           arg == "--precision" || arg == "--rare-event" || arg == "--rare-event-twist" ||
+                           arg == "--prescreen" || arg == "--export" || arg == "--export-out");
+        if (arg == "--aggregate-arrivals" || arg == "--rng" || arg == "--metrics-window" ||
+            arg == "--metrics-capacity" || arg == "--aqm" || arg == "--aqm-point" || arg == "--warmup" ||
+            arg == "--precision") {
+            opt.runOptionsSet = true;
+        }
+        if (takesValue && i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+
+        if (arg == "--event-queue") {
+            opt.eventQueue = argv[++i];
+            opt.eventQueueSet = true;
+        } else if (arg == "--topology") {
+            opt.topology = true;
+        } else if (arg == "--flows") {
+            opt.flows = true;
+        } else if (arg == "--aggregate-arrivals") {
+            opt.run.aggregateArrivals = true;
+        } else if (arg == "--rng") {
+            opt.run.randomEngine = parseRandomEngine(argv[++i]);
+        } else if (arg == "--replications") {
+            opt.replications = parseCount(arg, argv[++i]);
+            if (opt.replications == 0) throw std::invalid_argument("--replications must be positive");
+        } else if (arg == "--threads") {
+            opt.threads = static_cast<unsigned>(parseCount(arg, argv[++i]));
+            if (opt.threads == 0) throw std::invalid_argument("--threads must be positive");
+        } else if (arg == "--seed") {
+            opt.seed = parseCount(arg, argv[++i]);
+            opt.seedSet = true;
+        } else if (arg == "--buffer-bytes") {
+            opt.bufferBytes = static_cast<long long>(parseCount(arg, argv[++i]));
+        } else if (arg == "--sweep") {
+            opt.sweepAxes.push_back(argv[++i]);
+        } else if (arg == "--sweep-format") {
+            opt.sweepFormat = argv[++i];
+            if (opt.sweepFormat != "csv" && opt.sweepFormat != "json") {
+                throw std::invalid_argument("--sweep-format must be csv or json");
+            }
+        } else if (arg == "--sweep-out") {
+            opt.sweepOutput = argv[++i];
+        } else if (arg == "--trace") {
+            opt.traceFile = argv[++i];
+        } else if (arg == "--replay") {
+            opt.replayFile = argv[++i];
+        } else if (arg == "--replay-lookahead") {
+            opt.replayLookahead = parseCount(arg, argv[++i]);
+            if (opt.replayLookahead == 0) throw std::invalid_argument("--replay-lookahead must be positive");
+        } else if (arg == "--metrics-window") {
+            opt.run.metricsWindow = parsePositive(arg, argv[++i]);
+        } else if (arg == "--metrics-capacity") {
+            opt.run.metricsCapacity = parseCount(arg, argv[++i]);
+            if (opt.run.metricsCapacity == 0) throw std::invalid_argument("--metrics-capacity must be positive");
+        } else if (arg == "--metrics-out") {
+            opt.metricsOutput = argv[++i];
+        } else if (arg == "--aqm") {
+            AQMConfig aqm = parseAQMSpec(argv[++i]);
+            aqm.point = opt.run.aqm.point;
+            aqm.pointSet = opt.run.aqm.pointSet;
+            opt.run.aqm = aqm;
+        } else if (arg == "--aqm-point") {
+            opt.run.aqm.point = parseAQMPoint(argv[++i]);
+            opt.run.aqm.pointSet = true;
+        } else if (arg == "--warmup") {
+            std::string value = argv[++i];
+            opt.run.autoWarmup = value == "auto";
+            opt.run.warmup = opt.run.autoWarmup ? 0.0 : parseTime(arg, argv[i]);
+        } else if (arg == "--precision") {
+            opt.run.precision = parsePositive(arg, argv[++i]);
+            if (opt.run.precision >= 1.0) throw std::invalid_argument("--precision must be below 1");
+        } else if (arg == "--analytic") {
+            opt.analytic = true;
+        } else if (arg == "--prescreen") {
+            opt.prescreen = argv[++i];
+            parseAnalyticScreen(opt.prescreen);
+        } else if (arg == "--control-variate") {
+            opt.controlVariate = true;
+        } else if (arg == "--rare-event") {
+            opt.rareEventCycles = parseCount(arg, argv[++i]);
+            if (opt.rareEventCycles < 2) throw std::invalid_argument("--rare-event needs at least 2 cycles");
+        } else if (arg == "--rare-event-twist") {
+            opt.rareEventTwist = parsePositive(arg, argv[++i]);
+            if (opt.rareEventTwist < 1.0) throw std::invalid_argument("--rare-event-twist must be at least 1");
+        } else if (arg == "--export") {
+            opt.exportFormat = argv[++i];
+            parseExportFormat(opt.exportFormat);
+        } else if (arg == "--export-out") {
+            opt.exportOutput = argv[++i];
+        } else if (arg == "--checkpoint-at") {
+            opt.checkpointAt = parseTime(arg, argv[++i]);
+        } else if (arg == "--checkpoint-out") {
+            opt.checkpointOutput = argv[++i];
+        } else if (arg == "--restore") {
+            opt.restoreFile = argv[++i];
+        } else if (arg.compare(0, 2, "--") == 0) {
+            throw std::invalid_argument("Unknown option: " + arg);
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    if (positional.size() != 2) throw std::invalid_argument("Expected <scheduler> <input_file>");
+    if (!opt.traceFile.empty() && (opt.replications > 0 || !opt.sweepAxes.empty())) {
+        throw std::invalid_argument("--trace applies to single runs only");
+    }
+    if (!opt.replayFile.empty() && (opt.replications > 0 || !opt.sweepAxes.empty())) {
+        throw std::invalid_argument("--replay applies to single runs only");
+    }
+    if (opt.run.metricsWindow > 0.0 && (opt.replications > 0 || !opt.sweepAxes.empty())) {
+        throw std::invalid_argument("--metrics-window applies to single runs only");
+    }
+    if (opt.topology && (opt.replications > 0 || !opt.sweepAxes.empty() || !opt.traceFile.empty() ||
+                         !opt.replayFile.empty() || opt.run.metricsWindow > 0.0 ||
+                         opt.run.aggregateArrivals || opt.bufferBytes >= 0 || opt.eventQueue != "binary" ||
+                         opt.run.warmup > 0.0 || opt.run.autoWarmup || opt.run.precision > 0.0)) {
+        throw std::invalid_argument("--topology supports single runs with --rng, --seed, --threads and --aqm");
+    }
+    if (opt.flows && (opt.replications > 0 || !opt.sweepAxes.empty() || opt.topology || !opt.traceFile.empty() ||
+                      !opt.replayFile.empty() || opt.checkpointAt >= 0.0 || !opt.restoreFile.empty() ||
+                      opt.eventQueue != "binary" || opt.analytic || opt.rareEventCycles > 0 ||
+                      opt.controlVariate || opt.run.aggregateArrivals || opt.run.metricsWindow > 0.0 ||
+                      opt.run.aqm.policy != AQMPolicy::NONE || opt.run.aqm.pointSet || opt.run.warmup > 0.0 ||
+                      opt.run.autoWarmup || opt.run.precision > 0.0)) {
+        throw std::invalid_argument("--flows supports single runs with --rng, --seed and --buffer-bytes");
+    }
+    if ((opt.checkpointAt >= 0.0 || !opt.checkpointOutput.empty()) &&
+        (opt.replications > 0 || !opt.sweepAxes.empty() || !opt.replayFile.empty() || opt.topology)) {
+        throw std::invalid_argument("--checkpoint-at applies to single synthetic runs only");
+    }
+    if (!opt.checkpointOutput.empty() && opt.checkpointAt < 0.0) {
+        throw std::invalid_argument("--checkpoint-out requires --checkpoint-at");
+    }
+    if (!opt.restoreFile.empty()) {
+        if (!opt.sweepAxes.empty() || !opt.replayFile.empty() || opt.topology) {
+            throw std::invalid_argument("--restore cannot be combined with --sweep, --replay or --topology");
+        }
+        if (opt.runOptionsSet) {
+            throw std::invalid_argument("--restore takes the run options recorded in the checkpoint");
+        }
+    }
+    if (!opt.prescreen.empty() && opt.sweepAxes.empty()) {
+        throw std::invalid_argument("--prescreen applies to sweeps only");
+    }
+    if (!opt.prescreen.empty() && positional.size() == 2 && positional[0] != "fcfs") {
+        throw std::invalid_argument("--prescreen applies to the fcfs scheduler");
+    }
+    if (opt.controlVariate && opt.replications == 0 && opt.sweepAxes.empty()) {
+        throw std::invalid_argument("--control-variate requires --replications or --sweep");
+    }
+    if (opt.analytic) {
+        if (positional.size() == 2 && positional[0] != "fcfs") {
+            throw std::invalid_argument("--analytic applies to the fcfs scheduler");
+        }
+        if (opt.replications > 0 || !opt.sweepAxes.empty() || opt.topology || opt.rareEventCycles > 0 ||
+            !opt.replayFile.empty() || !opt.restoreFile.empty() || opt.checkpointAt >= 0.0 || opt.runOptionsSet) {
+            throw std::invalid_argument("--analytic takes only --buffer-bytes");
+        }
+    }
+    if (!opt.exportOutput.empty() && opt.exportFormat.empty()) {
+        throw std::invalid_argument("--export-out requires --export");
+    }
+    if (!opt.exportFormat.empty() && (opt.topology || opt.flows || opt.analytic || opt.rareEventCycles > 0)) {
+        throw std::invalid_argument("--export applies to single runs, replications and sweeps");
+    }
+    if (opt.rareEventTwist > 0.0 && opt.rareEventCycles == 0) {
+        throw std::invalid_argument("--rare-event-twist requires --rare-event");
+    }
+    if (opt.rareEventCycles > 0) {
+        if (positional.size() == 2 && positional[0] != "fcfs") {
+            throw std::invalid_argument("--rare-event applies to the fcfs scheduler");
+        }
+        if (opt.eventQueue != "binary" || opt.replications > 0 || !opt.sweepAxes.empty() ||
+            !opt.traceFile.empty() || !opt.replayFile.empty() || opt.topology || !opt.restoreFile.empty() ||
+            opt.checkpointAt >= 0.0 || opt.run.aggregateArrivals || opt.run.metricsWindow > 0.0 ||
+            opt.run.aqm.policy != AQMPolicy::NONE || opt.run.warmup > 0.0 || opt.run.autoWarmup ||
+            opt.run.precision > 0.0) {
+            throw std::invalid_argument("--rare-event supports only --rng, --seed, --threads and --buffer-bytes");
+        }
+    }
+#ifdef SIM_NO_TIMESERIES
+    if (opt.run.metricsWindow > 0.0) {
+        throw std::invalid_argument("--metrics-window is unavailable: built with SIM_NO_TIMESERIES");
+    }
+#endif
+    opt.scheduler = positional[0];
+    opt.inputFilename = positional[1];
+    return opt;
+}
+
+// Formats a report once, then writes it to the output file and, after `heading`, to the console
+template <class Print>
+static void emitReport(std::ofstream& file, const std::string& heading, Print print) {
+    std::ostringstream text;
+    print(text);
+    file << text.str();
+    std::cout << heading << text.str();
+}
+
+static void openExport(const Options& opt, ResultExporter& exporter) {
+    if (opt.exportFormat.empty()) return;
+    ExportFormat format = parseExportFormat(opt.exportFormat);
+    std::string filename = opt.exportOutput.empty()
+        ? opt.scheduler + "_results_" + opt.inputFilename + "." + exportExtension(format)
+        : opt.exportOutput;
+    exporter.open(filename, format);
+}
+
+static void closeExport(const Options& opt, ResultExporter& exporter) {
+    if (!exporter.enabled()) return;
+    exporter.close();
+    if (parseExportFormat(opt.exportFormat) == ExportFormat::CSV) {
+        std::cout << "Results exported to " << exporter.tablePath("<table>") << " files\n";
+    } else {
+        std::cout << "Results exported to " << exporter.filename() << "\n";
+    }
+}
+
+template <class Discipline, class EventQueue>
+static void runParameterSweep(const Options& opt, const Config& config) {
+    typedef Simulator<Discipline, EventQueue> Sim;
+    std::vector<SweepAxis> axes;
+    for (const auto& spec : opt.sweepAxes) axes.push_back(parseSweepAxis(spec, config));
+
+    std::string outputFilename = opt.sweepOutput.empty()
+        ? opt.scheduler + "_sweep_" + opt.inputFilename + "." + opt.sweepFormat
+        : opt.sweepOutput;
+    std::ofstream outputFile(outputFilename);
+    if (!outputFile) throw std::runtime_error("Could not create output file.");
+
+    AnalyticScreen screen;
+    if (!opt.prescreen.empty()) screen = parseAnalyticScreen(opt.prescreen);
+    size_t replications = std::max<size_t>(1, opt.replications);
+    ResultExporter exporter;
+    openExport(opt, exporter);
+    auto pointKeys = [&axes](size_t point) {
+        ExportKeys keys;
+        keys.emplace_back("point", static_cast<double>(point));
+        std::vector<size_t> coords = sweepCoordinates(axes, point);
+        for (size_t a = 0; a < axes.size(); ++a) keys.emplace_back(axes[a].name, axes[a].values[coords[a]]);
+        return keys;
+    };
+    RunCallback onRun;
+    if (exporter.enabled()) {
+        onRun = [&](size_t job, const Metrics& m) {
+            ExportKeys keys = pointKeys(job / replications);
+            keys.emplace_back("replication", static_cast<double>(job % replications));
+            exportMetrics(exporter, m, keys);
+        };
+    }
+    std::vector<ReplicationSummary> table = runSweep<Sim>(
+        config, axes, replications, opt.threads, opt.seed, opt.run,
+        opt.prescreen.empty() ? nullptr : &screen, opt.controlVariate, onRun);
+    if (exporter.enabled()) {
+        for (size_t p = 0; p < table.size(); ++p) exportSummary(exporter, table[p], pointKeys(p));
+    }
+
+    writeSweepTable(outputFile, opt.sweepFormat, axes, table);
+    std::cout << Discipline::name() << " sweep of " << table.size() << " points written to "
+              << outputFilename << "\n";
+    if (!opt.prescreen.empty()) {
+        size_t skipped = 0;
+        for (const auto& row : table) skipped += row.replications == 0;
+        std::cout << skipped << " points failed the analytic prescreen and were not simulated\n";
+    }
+    closeExport(opt, exporter);
+}
+
+template <class Discipline>
+static void runTopology(const Options& opt) {
+    TopologySimulator<Discipline> simulator;
+    simulator.configure(loadTopology(opt.inputFilename));
+    simulator.setRunOptions(opt.run);
+    simulator.seed(opt.seed);
+    simulator.setPartitions(opt.threads);
+
+    std::string outputFilename = opt.scheduler + "_output_" + opt.inputFilename;
+    std::ofstream outputFile(outputFilename);
+    if (!outputFile) throw std::runtime_error("Could not create output file.");
+
+    simulator.run();
+    std::cout << "Simulated " << simulator.eventCount() << " events on " << simulator.partitions() << " partition(s)";
+    if (simulator.windows() > 0) {
+        std::cout << " in " << simulator.windows() << " windows of lookahead " << simulator.lookahead() << " s";
+    }
+    std::cout << "\n";
+
+    emitReport(outputFile, "\n--- " + std::string(Discipline::name()) + " Topology Results for " + opt.inputFilename + " ---\n",
+               [&](std::ostream& out) { simulator.printResults(out); });
+    std::cout << "\nFull results written to " << outputFilename << "\n";
+}
+
+template <class Discipline>
+static void runFlows(const Options& opt) {
+    Config config = loadConfig(opt.inputFilename);
+    if (opt.bufferBytes >= 0) config.bufferBytes = static_cast<size_t>(opt.bufferBytes);
+    FlowSimulator<Discipline> simulator;
+    simulator.configure(config);
+    simulator.setRunOptions(opt.run);
+    simulator.seed(opt.seed);
+
+    std::string outputFilename = opt.scheduler + "_output_" + opt.inputFilename;
+    std::ofstream outputFile(outputFilename);
+    if (!outputFile) throw std::runtime_error("Could not create output file.");
+
+    simulator.run();
+    std::cout << "Simulated " << simulator.eventCount() << " events\n";
+
+    emitReport(outputFile, "\n--- " + std::string(Discipline::name()) + " Flow Results for " + opt.inputFilename + " ---\n",
+               [&](std::ostream& out) { simulator.printResults(out); });
+    std::cout << "\nFull results written to " << outputFilename << "\n";
+}
+
+static bool sameScenario(const Config& a, const Config& b) {
+    return a.numSources == b.numSources && a.simulationTime == b.simulationTime &&
+           a.linkCapacity == b.linkCapacity && a.bufferSize == b.bufferSize &&
+           a.bufferBytes == b.bufferBytes && a.sources.size() == b.sources.size() &&
+           (a.sources.empty() ||
+            std::memcmp(a.sources.data(), b.sources.data(), a.sources.size() * sizeof(SourceConfig)) == 0) &&
+           a.traffic.size() == b.traffic.size() &&
+           (a.traffic.empty() ||
+            std::memcmp(a.traffic.data(), b.traffic.data(), a.traffic.size() * sizeof(TrafficModel)) == 0) &&
+           a.sizeTables == b.sizeTables;
+}
+
+static std::string readSnapshot(const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) throw std::runtime_error("Could not open checkpoint file: " + filename);
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return bytes;
+}
+
+template <class Discipline, class EventQueue>
+static void runSimulation(const Options& opt) {
+    typedef Simulator<Discipline, EventQueue> Sim;
+    Config config = loadConfig(opt.inputFilename);
+    if (opt.bufferBytes >= 0) config.bufferBytes = static_cast<size_t>(opt.bufferBytes);
+    if (opt.controlVariate && !poissonArrivals(config)) {
+        throw std::runtime_error("--control-variate needs Poisson sources; " + opt.inputFilename + " has others");
+    }
+    if (!opt.sweepAxes.empty()) {
+        runParameterSweep<Discipline, EventQueue>(opt, config);
+        return;
+    }
+    std::string snapshot;
+    bool aggregated = opt.run.aggregateArrivals;
+    if (!opt.restoreFile.empty()) {
+        snapshot = readSnapshot(opt.restoreFile);
+        Sim probe;
+        probe.restore(snapshot);
+        aggregated = probe.runOptions().aggregateArrivals;
+        // The byte limit is a run option layered on the input, so it comes
+        // from the snapshot unless --buffer-bytes names a different one.
+        if (opt.bufferBytes < 0) {
+            config.bufferBytes = probe.config().bufferBytes;
+        } else if (config.bufferBytes != probe.config().bufferBytes) {
+            throw std::runtime_error("Checkpoint " + opt.restoreFile + " was taken with buffer byte limit " +
+                                     std::to_string(probe.config().bufferBytes) + ", not " +
+                                     std::to_string(config.bufferBytes));
+        }
+        if (!sameScenario(probe.config(), config)) {
+            throw std::runtime_error("Checkpoint " + opt.restoreFile + " was not taken from " + opt.inputFilename);
+        }
+    }
+
+    std::string outputFilename = opt.scheduler + "_output_" + opt.inputFilename;
+    std::ofstream outputFile(outputFilename);
+    if (!outputFile) throw std::runtime_error("Could not create output file.");
+
+    ResultExporter exporter;
+    openExport(opt, exporter);
+    if (opt.replications > 0) {
+        RunCallback onRun;
+        if (exporter.enabled()) {
+            onRun = [&exporter](size_t r, const Metrics& m) {
+                exportMetrics(exporter, m, ExportKeys{{"replication", static_cast<double>(r)}});
+            };
+        }
+        std::vector<Metrics> runs = snapshot.empty()
+            ? runReplications<Sim>(config, opt.replications, opt.threads, opt.seed, opt.run, onRun)
+            : runReplicationsFrom<Sim>(snapshot, opt.replications, opt.threads, opt.seed, onRun);
+        std::vector<double> controls;
+        if (opt.controlVariate) {
+            for (const auto& run : runs) controls.push_back(arrivalSurplus(run, config, aggregated));
+        }
+        ReplicationSummary summary = summarize(runs, opt.controlVariate ? &controls : nullptr);
+        if (opt.controlVariate) {
+            Estimate plain = summarize(runs).avgDelay;
+            if (summary.avgDelay.halfWidth > 0.0) {
+                double ratio = plain.halfWidth / summary.avgDelay.halfWidth;
+                if (ratio < 1.0) {
+                    std::cout << "Control variate widens the mean-delay interval " << std::fixed
+                              << std::setprecision(2) << 1.0 / ratio << "x; the plain estimate is tighter\n";
+                } else {
+                    std::cout << "Control variate narrows the mean-delay interval " << std::fixed
+                              << std::setprecision(2) << ratio << "x (worth " << ratio * ratio
+                              << "x the replications)\n";
+                }
+            }
+        }
+
+        if (exporter.enabled()) exportSummary(exporter, summary, ExportKeys());
+
+        emitReport(outputFile, "\n--- " + std::string(Discipline::name()) + " Replication Results for " + opt.inputFilename + " ---\n",
+                   [&](std::ostream& out) { printReplicationSummary(out, Discipline::name(), summary); });
+    } else {
+        Sim simulator;
+        if (snapshot.empty()) {
+            simulator.configure(config);
+            simulator.setRunOptions(opt.run);
+            simulator.seed(opt.seed);
+        } else {
+            simulator.restore(snapshot);
+            if (opt.seedSet) simulator.seed(opt.seed);
+            std::cout << "Restored " << opt.restoreFile << " at t = " << simulator.now() << " s\n";
+        }
+
+        TraceWriter trace;
+        if (!opt.traceFile.empty()) {
+            for (const auto& sc : simulator.config().sources) {
+                if (sc.maxSize > static_cast<int>(TraceRecord::kMaxSize)) {
+                    throw std::runtime_error("--trace records sizes up to " + std::to_string(TraceRecord::kMaxSize) +
+                                             " bytes; a source's MAX_SIZE is " + std::to_string(sc.maxSize));
+                }
+            }
+            trace.open(opt.traceFile);
+            simulator.setTrace(&trace);
+        }
+        ReplayStream replay;
+        if (!opt.replayFile.empty()) {
+            replay.open(opt.replayFile, opt.replayLookahead);
+            simulator.setReplay(&replay);
+        }
+        if (!snapshot.empty()) {
+            simulator.resume();
+        } else if (opt.checkpointAt >= 0.0) {
+            std::string checkpointFilename = opt.checkpointOutput.empty()
+                ? opt.scheduler + "_checkpoint_" + opt.inputFilename + ".bin"
+                : opt.checkpointOutput;
+            simulator.start();
+            simulator.advance(opt.checkpointAt);
+            std::ofstream checkpointFile(checkpointFilename, std::ios::binary);
+            if (!checkpointFile) throw std::runtime_error("Could not create checkpoint file.");
+            std::string bytes = simulator.checkpoint();
+            checkpointFile.write(bytes.data(), bytes.size());
+            if (!checkpointFile) throw std::runtime_error("Could not write checkpoint file.");
+            std::cout << "Checkpoint at t = " << simulator.now() << " s (" << bytes.size()
+                      << " bytes) written to " << checkpointFilename << "\n";
+            simulator.resume();
+        } else {
+            simulator.run();
+        }
+        trace.close();
+
+        if (!opt.replayFile.empty()) {
+            std::cout << "Replayed " << replay.arrivals() << " arrivals from " << opt.replayFile;
+            if (replay.reordered() > 0) {
+                std::cout << " (" << replay.reordered() << " beyond the lookahead were clamped in time)";
+            }
+            std::cout << "\n";
+        }
+        if (opt.run.autoWarmup) {
+            if (simulator.warmupCutTime() < 0.0) {
+                std::cout << "MSER-5 found no end of the warm-up; statistics cover the whole run\n";
+            } else if (simulator.warmupCutTime() == 0.0) {
+                std::cout << "MSER-5 found no warm-up transient; statistics cover the whole run\n";
+            } else {
+                std::cout << "MSER-5 placed the end of the warm-up at " << simulator.warmupCutTime()
+                          << " s; statistics collected from t = " << simulator.measurementStart() << " s\n";
+            }
+        } else if (simulator.measurementStart() > 0.0) {
+            std::cout << "Statistics collected from t = " << simulator.measurementStart() << " s\n";
+        }
+        if (simulator.stoppedEarly()) {
+            Estimate d = simulator.delayEstimate();
+            std::cout << "Stopped at t = " << simulator.now() << " s: mean delay " << d.mean
+                      << " +/- " << d.halfWidth << " s meets the precision target\n";
+        }
+        if (simulator.aqm().policy() != AQMPolicy::NONE) {
+            std::cout << aqmPolicyName(simulator.aqm().policy()) << " dropped "
+                      << simulator.aqm().earlyDrops() << " packets early\n";
+        }
+
+#ifndef SIM_NO_TIMESERIES
+        if (simulator.timeSeries().enabled()) {
+            std::string seriesFilename = opt.metricsOutput.empty()
+                ? opt.scheduler + "_timeseries_" + opt.inputFilename + ".csv"
+                : opt.metricsOutput;
+            std::ofstream seriesFile(seriesFilename);
+            if (!seriesFile) throw std::runtime_error("Could not create output file.");
+            simulator.timeSeries().write(seriesFile);
+            std::cout << simulator.timeSeries().size() << " metrics windows written to " << seriesFilename << "\n";
+        }
+#endif
+
+        if (exporter.enabled()) exportMetrics(exporter, simulator.metrics(), ExportKeys());
+
+        emitReport(outputFile, "\n--- " + std::string(Discipline::name()) + " Results for " + opt.inputFilename + " ---\n",
+                   [&](std::ostream& out) { simulator.printResults(out); });
+    }
+    closeExport(opt, exporter);
+    std::cout << "\nFull results written to " << outputFilename << "\n";
+}
+
+static void runAnalytic(const Options& opt) {
+    Config config = loadConfig(opt.inputFilename);
+    if (opt.bufferBytes >= 0) config.bufferBytes = static_cast<size_t>(opt.bufferBytes);
+    AnalyticResult result = analyzeScenario(config);
+
+    std::string outputFilename = opt.scheduler + "_output_" + opt.inputFilename;
+    std::ofstream outputFile(outputFilename);
+    if (!outputFile) throw std::runtime_error("Could not create output file.");
+    emitReport(outputFile, "\n--- FCFS Analytic Results for " + opt.inputFilename + " ---\n",
+               [&](std::ostream& out) { printAnalyticResults(out, result); });
+    std::cout << "\nFull results written to " << outputFilename << "\n";
+}
+
+static void runRareEvent(const Options& opt) {
+    Config config = loadConfig(opt.inputFilename);
+    if (opt.bufferBytes >= 0) config.bufferBytes = static_cast<size_t>(opt.bufferBytes);
+    FCFSRareEventEstimator estimator;
+    estimator.configure(config);
+
+    RareEventOptions options;
+    options.cycles = opt.rareEventCycles;
+    options.twist = opt.rareEventTwist;
+    options.threads = opt.threads;
+    options.seed = opt.seed;
+    options.randomEngine = opt.run.randomEngine;
+    RareEventResult result = estimator.run(options);
+
+    std::string outputFilename = opt.scheduler + "_output_" + opt.inputFilename;
+    std::ofstream outputFile(outputFilename);
+    if (!outputFile) throw std::runtime_error("Could not create output file.");
+    emitReport(outputFile, "\n--- FCFS Rare-Event Results for " + opt.inputFilename + " ---\n",
+               [&](std::ostream& out) { printRareEventResult(out, result); });
+    std::cout << "\nFull results written to " << outputFilename << "\n";
+}
+
+template <class Discipline>
+static void selectEventQueue(const Options& opt) {
+    if (opt.topology) {
+        runTopology<Discipline>(opt); // Uses its own tie-stable event heap
+    } else if (opt.eventQueue == "binary") {
+        runSimulation<Discipline, BinaryHeapQueue>(opt);
+    } else if (opt.eventQueue == "dary") {
+        runSimulation<Discipline, QuaternaryHeapQueue>(opt);
+    } else if (opt.eventQueue == "calendar") {
+        runSimulation<Discipline, CalendarQueue>(opt);
+    } else if (opt.eventQueue == "ladder") {
+        runSimulation<Discipline, LadderQueue>(opt);
+    } else {
+        throw std::runtime_error("Unknown event queue: " + opt.eventQueue);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    try {
+        opt = parseOptions(argc, argv);
+    } catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << "\n";
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    try {
+        if (!opt.restoreFile.empty() && !opt.eventQueueSet) {
+            opt.eventQueue = checkpointEventQueue(readSnapshot(opt.restoreFile));
+        }
+        if (opt.analytic) {
+            runAnalytic(opt);
+        } else if (opt.flows) {
+            if (opt.scheduler == "fcfs") {
+                runFlows<FlowFCFSDiscipline>(opt);
+            } else if (opt.scheduler == "wfq") {
+                runFlows<FlowWFQDiscipline>(opt);
+            } else {
+                throw std::runtime_error("Flow mode supports the fcfs and wfq schedulers");
+            }
+        } else if (opt.rareEventCycles > 0) {
+            runRareEvent(opt);
+        } else if (opt.scheduler == "fcfs") {
+            selectEventQueue<FCFSDiscipline>(opt);
+        } else if (opt.scheduler == "wfq") {
+            selectEventQueue<WFQDiscipline>(opt);
+        } else if (opt.scheduler == "wfq-legacy") {
+            selectEventQueue<LegacyWFQDiscipline>(opt);
+        } else if (opt.scheduler == "drr") {
+            selectEventQueue<DRRDiscipline>(opt);
+        } else if (opt.scheduler == "sfq") {
+            selectEventQueue<SFQDiscipline>(opt);
+        } else {
+            throw std::runtime_error("Unknown scheduler: " + opt.scheduler);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
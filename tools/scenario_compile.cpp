@@ -0,0 +1,26 @@
+/**
+ * @file scenario_compile.cpp
+ * @brief Converts a text scenario into the compiled binary form (see sim/config.h).
+ */
+
+#include <iostream>
+#include <stdexcept>
+
+#include "../sim/config.h"
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <input_file> <output_file>\n";
+        return 1;
+    }
+
+    try {
+        Config config = loadConfig(argv[1]);
+        saveBinaryConfig(config, argv[2]);
+        std::cout << "Compiled " << config.sources.size() << " sources into " << argv[2] << "\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,34 @@
+/**
+ * @file trace_dump.cpp
+ * @brief Prints a binary packet trace (see sim/trace.h) as CSV.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <stdexcept>
+
+#include "../sim/trace.h"
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <trace_file>\n";
+        return 1;
+    }
+
+    try {
+        TraceReader trace(argv[1]);
+        static const char* typeNames[] = {"arrival", "drop", "departure"};
+
+        std::cout << "type,time,packet_id,source,size,arrival_time,virtual_finish_time\n"
+                  << std::setprecision(9);
+        for (const TraceRecord& r : trace) {
+            std::cout << typeNames[r.type()] << "," << r.time << "," << r.packetId << ","
+                      << r.sourceID << "," << r.size() << "," << r.arrivalTime << ","
+                      << r.virtualFinishTime << "\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}